@@ -0,0 +1,50 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// Client buzzer debounce state machine (DebounceMode in config.h)
+// Pin level and time are handed in by the caller - ClientButtonHandler reads
+// the GPIO and esp_timer, the host tests replay recorded bounce traces - so
+// nothing in here touches the hardware.
+class ButtonDebouncer {
+private:
+  // Lock-out debounce states
+  enum class LockState : uint8_t {
+    ARMED,      // Released, next edge is a press
+    PRESSED,    // Press fired, chatter ignored, waiting for release
+    RELEASING   // Released, waiting for release chatter to settle
+  };
+
+  DebounceMode mode;
+  LockState lockState;
+  int64_t lockStartUs;
+
+  // Stable mode - level must hold for DEBOUNCE_MS before it counts
+  bool stableDown;
+  bool rawDown;
+  int64_t rawChangedUs;
+
+  int64_t pressTimeUs;
+  bool pressed;
+
+  // Falling edge captured by the interrupt - single slot, captureEdge() only
+  // writes while it is empty, update() only reads while it is full
+  volatile int64_t edgeTimeUs;
+  volatile bool edgeCaptured;
+
+  void updateStable(bool down, int64_t nowUs);
+  void updateLockOut(bool down, int64_t nowUs);
+  void registerPress(int64_t timeUs);
+
+public:
+  explicit ButtonDebouncer(DebounceMode debounceMode = CLIENT_DEBOUNCE_MODE);
+
+  // Falling edge interrupt - down: pin level read in the interrupt
+  void IRAM_ATTR captureEdge(bool down, int64_t timeUs);
+
+  // Poll from the loop - down: current pin level, nowUs: esp_timer time base
+  void update(bool down, int64_t nowUs);
+
+  bool wasPressed();   // clears the press
+  int64_t getPressTimeUs() const;
+};
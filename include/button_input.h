@@ -0,0 +1,60 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "protocol.h"
+#include "spsc_queue.h"
+
+// Server button input - main button plus the dedicated NEXT and CORRECT
+// buttons. Edge interrupts timestamp every change and queue it, update()
+// debounces the edges in the loop task and turns them into button events:
+//  - main: SHORT on release, LONG on release after LONG_PRESS_MS,
+//    VERY_LONG once held for VERY_LONG_PRESS_MS
+//  - NEXT / CORRECT: fire on the press edge, no hold needed
+struct ButtonEvent {
+  ButtonPress press;
+  uint32_t pressTime;   // millis() of the press edge
+};
+
+class ButtonInput {
+private:
+  enum Button : uint8_t {
+    MAIN = 0,
+    NEXT,
+    CORRECT,
+    BUTTON_COUNT
+  };
+  
+  // Timestamped edge from the interrupt
+  struct Edge {
+    uint8_t button;
+    bool down;
+    uint32_t time;   // millis() time base
+  };
+  
+  struct State {
+    bool down;
+    uint32_t changedAt;   // last accepted edge - chatter inside DEBOUNCE_MS is ignored
+    uint32_t pressedAt;
+    bool holdFired;       // VERY_LONG already sent for this press
+  };
+  
+  static const uint8_t PINS[BUTTON_COUNT];
+  static SpscQueue<Edge, BUTTON_EDGE_QUEUE> edges;
+  static void IRAM_ATTR onEdge(void* arg);
+  
+  State states[BUTTON_COUNT];
+  SpscQueue<ButtonEvent, BUTTON_EVENT_QUEUE> events;
+  
+  void applyEdge(uint8_t button, bool down, uint32_t time);
+  void emit(ButtonPress press, uint32_t pressTime);
+  
+public:
+  ButtonInput();
+  void begin();    // pull-ups and edge interrupts on all three pins
+  void update();   // debounces queued edges and held buttons into events
+  bool nextEvent(ButtonEvent& event);
+  uint32_t msUntilDue() const;   // until a held main button turns VERY_LONG, UINT32_MAX if none
+};
+
+// Global instance
+extern ButtonInput* buttonInput;
@@ -0,0 +1,44 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// Buzz order of the current question - gameClients indices in a fixed ring,
+// plus a bitmap of every client that buzzed (queued or still held in the
+// arbitration window). Position 0 is the front, the answering client.
+//
+// Removal is O(1) at the front, which is the only place the game removes
+// from (wrong answer pops the answering client). Removing further back
+// shifts the tail like a sorted insert does - at most MAX_CLIENTS - 1 bytes.
+// Tombstones would keep that O(1) but make at() and size() skip entries,
+// and the queue is read by position far more often than it is changed.
+class BuzzQueue {
+private:
+  static_assert(MAX_CLIENTS <= 16, "buzzed bitmap holds 16 clients");
+  
+  uint8_t entries[MAX_CLIENTS];
+  uint8_t head;
+  uint8_t count;
+  uint16_t buzzedMask;
+  
+  uint8_t slotOf(uint8_t position) const;
+  
+public:
+  BuzzQueue();
+  void clear();   // empties the queue and forgets who buzzed
+  
+  uint8_t size() const;
+  bool isEmpty() const;
+  bool isFull() const;
+  uint8_t at(uint8_t position) const;
+  int8_t find(uint8_t client) const;   // position, -1 if not queued
+  
+  bool push(uint8_t client);                      // O(1) at the back
+  bool insert(uint8_t position, uint8_t client);  // sorted insert, shifts the tail
+  uint8_t popFront();                             // O(1), UINT8_MAX if empty
+  bool remove(uint8_t position);                  // O(1) at the front, shifts the tail otherwise
+  
+  // Who buzzed this question
+  void markBuzzed(uint8_t client);
+  void clearBuzzed(uint8_t client);
+  bool hasBuzzed(uint8_t client) const;
+};
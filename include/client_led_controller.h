@@ -17,12 +17,13 @@ public:
   void setAllLEDs(const Rgb& color);
   void showRGBTest();
   
-  // Client-specific animations
+  // Client-specific animations - one step per call, paced by the LED frame timer
   void showSolidColor(const Rgb& color);        // Solid color (not OPEN)
-  void animateIdle(const Rgb& color);           // Soft pulse in assigned color (OPEN state)
+  // Shared effects render from hub time / elapsed time so all boards stay in phase
+  void animateIdle(const Rgb& color, uint32_t hubTime); // Soft pulse in assigned color (OPEN state)
   void animateActiveSpin(const Rgb& color);     // Fast spinning animation
-  void animateFlash(const Rgb& color);          // Quick flash animation
-  void animateCelebration();                    // Rainbow animation
+  void animateFlash(const Rgb& color, uint32_t elapsed); // Quick flash animation
+  void animateCelebration(uint32_t elapsed);    // Rainbow animation
   void animateDisconnected();                   // Red pulse (no connection)
   void showLocked(const Rgb& color);            // Solid player color (buzzed)
   
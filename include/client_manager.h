@@ -1,8 +1,8 @@
 #pragma once
 #include <Arduino.h>
-#include <Bounce2.h>
 #include "config.h"
 #include "protocol.h"
+#include "button_debounce.h"
 
 // Client state management
 class ClientManager {
@@ -14,27 +14,45 @@ public:
     ClientState currentState;
     bool hasBuzzed;
     bool isActive;
+    uint32_t stateSince;   // Local time the current state (effect) started
   };
   
 private:
   ClientData data;
   
+  // State change deferred to a shared effect start instant
+  ClientState scheduledState;
+  uint32_t scheduledAt;
+  bool hasScheduledState;
+  
+  uint8_t frameTimer;       // LED frame timer, period follows the state
+  ClientState frameState;   // state the frame timer is set up for
+  
 public:
   ClientManager();
+  void begin();   // LED frame timer - after eventLoop.begin()
   
   // State management
   void setState(ClientState newState);
+  void setState(ClientState newState, uint32_t since);
+  void scheduleState(ClientState newState, uint32_t localStart); // Apply at localStart (millis)
+  void cancelScheduledState();
   ClientState getState() const;
-  void handleStateAnimations();
+  void handleStateAnimations();   // applies due scheduled states, re-times the LED frames
+  void renderState();             // one LED frame of the current state
+  uint32_t msUntilScheduled() const;  // until the scheduled state is due, UINT32_MAX if none
   
   // Assignment handling
   void setAssignment(uint8_t slot, const Rgb& color);
   bool isAssigned() const;
+  void restore(uint8_t slot, const Rgb& color, bool queued, bool active);  // Reconnect snapshot, keeps an unacked buzz locked
   
   // Buzz handling
-  void buzz();
+  void buzz(int64_t pressTimeUs); // pressTimeUs: captured button edge (esp_timer time base)
   bool canBuzz() const;
   void resetBuzzState();
+  void confirmBuzz();   // server queued us - locked unless already answering
+  void releaseBuzz();   // buzz not queued or dropped - free to buzz again
   
   // Getters
   const ClientData& getData() const;
@@ -42,17 +60,22 @@ public:
   const Rgb& getAssignedColor() const;
 };
 
-// Button handling for client
+// Button handling for client - GPIO and esp_timer side of ButtonDebouncer
 class ClientButtonHandler {
 private:
-  Bounce& button;
-  uint32_t lastButtonPress;
-  bool buttonPressed;
+  ButtonDebouncer debouncer;
+  
+  static void IRAM_ATTR onButtonEdge(void* arg);
   
 public:
-  ClientButtonHandler(Bounce& btn);
+  ClientButtonHandler(DebounceMode debounceMode = CLIENT_DEBOUNCE_MODE);
+  void begin();  // Button pin and edge interrupt on BUTTON_PIN
   void update();
   bool wasPressed();
+  
+  // Time of the last press, taken from the interrupt edge
+  uint32_t getPressTime() const;   // millis() time base
+  int64_t getPressTimeUs() const;  // esp_timer time base
 };
 
 // Global instances
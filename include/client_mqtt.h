@@ -2,9 +2,10 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <PubSubClient.h>
-#include <ArduinoJson.h>
 #include "config.h"
 #include "protocol.h"
+#include "clock_sync.h"
+#include "wire_codec.h"
 
 // Client MQTT Manager
 class ClientMQTT {
@@ -13,8 +14,63 @@ private:
   PubSubClient mqttClient;
   String clientId;
   bool connected;
-  uint32_t lastConnectionAttempt;
-  uint32_t lastPing;
+  
+  // Connection state machine - advanced by loop(), never waits on the network
+  enum class LinkState : uint8_t {
+    WIFI_CONNECTING,   // WiFi.begin() issued, waiting for the association
+    WIFI_BACKOFF,      // waiting for the next Wi-Fi attempt
+    MQTT_BACKOFF,      // Wi-Fi up, waiting for the next broker attempt
+    CONNECTED
+  };
+  LinkState linkState;
+  uint32_t linkSince;     // entered the current state
+  uint32_t retryAt;       // next attempt, backoff states
+  uint8_t wifiAttempts;   // failed attempts since the last success - backoff exponent
+  uint8_t mqttAttempts;
+  
+  void updateLink();
+  void setLinkState(LinkState state);
+  void enterBackoff(LinkState state, uint8_t& attempts);
+  Wire::Codec codec;    // JSON until the server confirms binary
+  
+  // Pre-built MQTT PUBLISH frame for quiz/buzz - only sequence and timestamp
+  // get patched on press, then the frame goes out in a single socket write
+  uint8_t buzzFrame[BUZZ_FRAME_SIZE];
+  uint8_t buzzFrameLength;
+  uint8_t buzzFrameSeqOffset;
+  uint8_t buzzFrameTimeOffset;
+  bool buzzFrameReady;
+  Wire::Codec buzzFrameCodec;
+  
+  // Hub clock estimate and buzz latency, sampled from buzz acks
+  ClockSync hubClock;
+  uint32_t lastBuzzPressTime;
+  uint32_t lastBuzzSendTime;
+  
+  // Buzz retransmit until acked - same sequence number and press time
+  uint16_t buzzSeq;
+  uint8_t buzzRetries;
+  bool buzzPending;
+  
+  bool writeBuzzFrame(uint16_t seq, uint32_t pressTime);
+  bool buzzIsOffline;   // buffered buzz, sent with hub press time
+  bool buzzFalseStart;  // pressed before the announced open instant
+  uint32_t lastConnectedTime;
+  bool joinAnswered;    // assignment or snapshot received on this connection
+  
+  bool transmitBuzz();
+  void retransmitBuzz();
+  void deliverOfflineBuzz();
+  
+  // Announced question open instant, converted to local clock
+  bool openScheduled;
+  uint32_t openLocalTime;
+  
+  void updateOpenSchedule();
+  
+  // Receive path statistics since join (heap allocations in HEAP_COUNTER builds)
+  uint32_t receivedMessages;
+  uint32_t receiveAllocations;
   
 public:
   ClientMQTT();
@@ -23,30 +79,54 @@ public:
   void begin();
   void loop();
   bool isConnected();
+  bool isLive() const;            // question live or buzz unacked - poll the network tightly
+  uint32_t msUntilDue() const;    // until the next open/retransmit/reconnect deadline, UINT32_MAX if none
   
   // WiFi functions
-  bool connectWiFi();
+  void startWiFi();   // starts an association, loop() follows it up
   void disconnectWiFi();
   
   // MQTT functions
-  bool connectMQTT();
+  bool connectMQTT();   // bounded by MQTT_CONNECT_TIMEOUT_MS and MQTT_CONNACK_TIMEOUT_S
   void disconnectMQTT();
   void onMessage(char* topic, byte* payload, unsigned int length);
+  void resetReceiveStats();
+  void logReceiveStats();
   
   // Game communication
   void sendJoinRequest();
-  void sendBuzz();
-  void sendPing();
+  void setCodec(Wire::Codec newCodec);
+  void prepareBuzzFrame();
+  void sendBuzz(int64_t pressTimeUs);
+  void sendPing(uint32_t echoTime = 0); // echoTime: server PING_REQUEST time, 0 = unsolicited
+  bool onBuzzAck(uint16_t seq, uint32_t serverTime);  // false for a stale ack of an older buzz
+  void onClockSync(uint32_t clientTime, uint32_t serverTime);
+  void onJoined();   // join answered - hands over a buffered offline buzz
+  void cancelBuzzRetransmit();
+  bool canBufferBuzz();
+  bool hasBuzzInFlight() const;   // sent and not acked yet, or buffered offline
+  
+  // Synchronized question opening
+  void scheduleOpen(uint32_t hubOpenAt);
+  void clearOpenSchedule();
+  bool isFalseStart(uint32_t pressTime) const;
+  
+  // Hub time base for shared effects (identity until synced)
+  bool isHubSynced() const;
+  uint32_t hubToLocal(uint32_t hubTime) const;
+  uint32_t localToHub(uint32_t localTime) const;
   
   // Getters
   const String& getClientId() const;
 };
 
-// MQTT Message handlers
-void handleAssignment(const String& payload);
-void handleGameState(const String& payload);
-void handleQueue(const String& payload);
-void handleCommand(const String& payload);
+// MQTT Message handlers - payloads in either wire encoding
+void handleAssignment(const uint8_t* payload, size_t length);
+void handleGameState(const uint8_t* payload, size_t length);
+void handleQueue(const uint8_t* payload, size_t length);
+void handleCommand(const uint8_t* payload, size_t length);
+void handleBuzzAck(const uint8_t* payload, size_t length);
+void handleClockSync(const uint8_t* payload, size_t length);
 
 // Global MQTT client instance
 extern ClientMQTT* clientMqtt;
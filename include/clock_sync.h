@@ -0,0 +1,38 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// Clock offset estimation from ping round-trips (NTP-style)
+// One side sends its local time, the other answers with its own clock,
+// the sender timestamps the reply. Offset = remote - local clock.
+class ClockSync {
+private:
+  struct Sample {
+    int32_t offset;
+    uint32_t rtt;
+  };
+  
+  Sample samples[CLOCK_SYNC_WINDOW];
+  uint8_t sampleCount;
+  uint8_t nextSample;
+  int32_t offset;
+  uint32_t rtt;
+  uint32_t jitter;
+  
+public:
+  ClockSync();
+  void reset();
+  
+  // Feed one round-trip, returns false if the sample was discarded
+  bool addSample(uint32_t localSend, uint32_t remoteTime, uint32_t localReceive);
+  
+  // Estimate state
+  bool isSynced() const;
+  int32_t getOffset() const;
+  uint32_t getRtt() const;
+  uint32_t getJitter() const;   // smoothed round-trip excess over the best path
+  
+  // Time conversion between both clocks
+  uint32_t toLocal(uint32_t remoteTime) const;
+  uint32_t toRemote(uint32_t localTime) const;
+};
@@ -23,9 +23,17 @@ constexpr uint8_t LED_BRIGHTNESS = 64; // 0..255 (64 = 25% to prevent brownouts)
 
 // Button Timing Configuration (ms)
 constexpr uint16_t DEBOUNCE_MS = 20;
+
+// Client buzzer debounce mode
+// STABLE:   press counts after DEBOUNCE_MS of stable contact
+// LOCK_OUT: press counts on the first edge, chatter is ignored for DEBOUNCE_MS
+enum class DebounceMode : uint8_t { STABLE, LOCK_OUT };
+constexpr DebounceMode CLIENT_DEBOUNCE_MODE = DebounceMode::LOCK_OUT;
 constexpr uint16_t SHORT_PRESS_MAX_MS = 600;
 constexpr uint16_t LONG_PRESS_MS = 1200;
 constexpr uint16_t VERY_LONG_PRESS_MS = 4000;
+constexpr uint8_t BUTTON_EDGE_QUEUE = 16;   // Server: edges from the interrupts, not yet debounced (power of 2)
+constexpr uint8_t BUTTON_EVENT_QUEUE = 8;   // Server: button events waiting for GameManager (power of 2)
 
 // WiFi/Network Configuration
 constexpr char WIFI_SSID[] = "QUIZ-HUB";
@@ -40,14 +48,63 @@ constexpr char WIFI_PSK[] = "quiz12345"; // TODO: Change in production
 constexpr char MQTT_HOST[] = "192.168.4.1";
 constexpr uint16_t MQTT_PORT = 1883;
 constexpr uint16_t MQTT_KEEPALIVE_INTERVAL = 60;
+constexpr uint16_t WIFI_CONNECT_TIMEOUT_MS = 10000;   // Give up one Wi-Fi association attempt after 10s
+constexpr uint16_t MQTT_CONNECT_TIMEOUT_MS = 250;     // TCP connect to the broker (same AP, answers in ms)
+constexpr uint8_t MQTT_CONNACK_TIMEOUT_S = 1;         // PubSubClient waits this long for CONNACK
+constexpr uint16_t RECONNECT_BACKOFF_MIN_MS = 500;    // First retry after 250-500ms (half fixed, half random)
+constexpr uint16_t RECONNECT_BACKOFF_MAX_MS = 8000;   // Delay doubles per failed attempt up to 8s
+constexpr uint8_t BUZZ_FRAME_SIZE = 64;              // Pre-built buzz PUBLISH frame buffer
+constexpr uint8_t BUZZ_FRAME_SEQ_DIGITS = 5;        // uint16 sequence field width
+constexpr uint8_t BUZZ_FRAME_TIME_DIGITS = 10;      // uint32 timestamp field width
+constexpr uint16_t BUZZ_RETRY_MS = 60;              // Retransmit unacked buzz after 60ms
+constexpr uint8_t BUZZ_RETRY_MAX = 8;               // Give up after 8 retransmits
+constexpr uint16_t OFFLINE_BUZZ_MAX_MS = 3000;      // Buffer presses during Wi-Fi drops up to 3s
+constexpr uint8_t WIRE_BINARY_MAGIC = 0xB1;          // First byte of binary payloads (codec v1)
+constexpr uint8_t WIRE_ID_MAX = 16;                 // Longest client ID on the wire
+constexpr uint16_t WIRE_FRAME_MAX = 256;            // Encode buffer for one payload
+constexpr uint8_t WIRE_TOPIC_MAX = 32;               // Directed topic (prefix + client ID)
+constexpr uint8_t OUTBOUND_POOL_SIZE = 4;           // Preallocated server publish buffers
+constexpr uint8_t OUTBOUND_COMMAND_QUEUE = 16;      // Commands held per loop tick before flush
+constexpr uint8_t CLIENT_ID_TABLE_SIZE = 32;        // ID -> client index hash table (power of 2, > 2x MAX_CLIENTS)
+constexpr uint16_t LOG_LINE_MAX = 192;              // Server log line buffer
+
+// Server Tasks (PicoMQTT broker on core 0, game logic and LEDs in the loop task on core 1)
+constexpr uint8_t NETWORK_TASK_CORE = 0;
+constexpr uint8_t NETWORK_TASK_PRIORITY = 2;         // Above the loop task, below the Wi-Fi stack
+constexpr uint16_t NETWORK_TASK_STACK = 6144;
+constexpr uint8_t INBOUND_QUEUE_SIZE = 8;            // Received messages waiting for the game task (power of 2)
+constexpr uint8_t OUTBOUND_FRAME_QUEUE = 16;         // Publishes waiting for the broker task (power of 2)
 
 // Game Configuration
 constexpr uint8_t MAX_CLIENTS = 10;
 constexpr uint8_t MIN_CLIENTS_TO_START = 1;
+constexpr uint16_t BOOT_LOBBY_TIMEOUT_MS = 15000; // BOOT moves on to LOBBY on its own after 15s
+constexpr uint8_t SCHEDULER_CAPACITY = 8;        // Deferred server actions pending at once
 
 // Ping Configuration
 constexpr uint16_t PING_INTERVAL_MS = 5000;     // Ping every 5 seconds
 constexpr uint16_t CLIENT_TIMEOUT_MS = 10000;   // Consider client dead after 10 seconds
+constexpr uint16_t CLIENT_CHECK_INTERVAL_MS = 5000;  // Server checks for timed out clients every 5 seconds
+constexpr uint16_t CLIENT_PING_INTERVAL_MS = 10000;  // Client pings on its own every 10 seconds
+
+// Event Loop (loop task sleeps until an event, a due timer or the next network poll)
+constexpr uint8_t EVENT_TIMER_MAX = 6;            // Periodic timers per board
+constexpr uint16_t EVENT_POLL_ACTIVE_MS = 2;      // Network poll while a question is live
+constexpr uint16_t EVENT_POLL_IDLE_MS = 20;       // Network poll otherwise
+constexpr uint32_t EVENT_STATS_INTERVAL_MS = 60000; // Log timer jitter every minute
+
+// Clock Sync Configuration (offset estimation over ping round-trips)
+constexpr uint8_t CLOCK_SYNC_WINDOW = 8;         // Keep the last 8 round-trips
+constexpr uint16_t CLOCK_SYNC_MAX_RTT_MS = 500;  // Discard slower round-trips
+
+// Synchronized Question Opening (ARM announces the open instant ahead of time)
+constexpr uint16_t QUESTION_ARM_LEAD_MS = 250;   // Open instant this far after ARM
+constexpr uint16_t FALSE_START_TOLERANCE_MS = 10; // Clock estimate slack before calling a false start
+
+// Buzz Arbitration Window (hold near-simultaneous buzzes, then sort by press time)
+constexpr uint16_t BUZZ_WINDOW_MIN_MS = 30;      // Shortest collection window
+constexpr uint16_t BUZZ_WINDOW_MAX_MS = 80;      // Longest window (also used until clocks are synced)
+constexpr uint8_t BUZZ_WINDOW_JITTER_FACTOR = 4; // Window = factor x worst client jitter
 
 // RGB Color Structure
 struct Rgb {
@@ -79,3 +136,6 @@ constexpr uint16_t PULSE_SPEED_MS = 50;
 constexpr uint16_t SPIN_SPEED_MS = 60;
 constexpr uint16_t CELEBRATION_DURATION_MS = 5000;
 constexpr uint16_t FLASH_DURATION_MS = 200;
+constexpr uint16_t CELEBRATION_FRAME_MS = 50;   // Rainbow frame period (server & clients)
+constexpr uint16_t EFFECT_START_LEAD_MS = 60;   // Effects start this far ahead so all boards begin together
+constexpr uint16_t WRONG_RESET_DELAY_MS = EFFECT_START_LEAD_MS + FLASH_DURATION_MS * 4; // RESET once the wrong flash has played out
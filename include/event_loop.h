@@ -0,0 +1,64 @@
+#pragma once
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "config.h"
+
+// Event-driven main loop shared by server and client
+//
+// The loop task sleeps on its FreeRTOS task notification instead of a fixed
+// delay. Button edges and other tasks wake it right away, otherwise it
+// wakes for the next due timer or the next poll. The client's MQTT library
+// has no data-ready callback, so it polls its socket every
+// EVENT_POLL_ACTIVE_MS while a question is live, EVENT_POLL_IDLE_MS otherwise.
+// The server broker runs in its own task (network_task.h) and wakes the loop
+// for every received message.
+//
+// Timers are periodic and keep their phase (next due = last due + period).
+// Every timer records how late it fired, logged every EVENT_STATS_INTERVAL_MS.
+typedef void (*TimerCallback)();
+
+class EventLoop {
+private:
+  struct Timer {
+    const char* name;
+    TimerCallback callback;
+    uint32_t periodUs;
+    uint32_t dueUs;       // micros() time base
+    uint32_t fires;
+    uint32_t maxLateUs;
+    uint64_t totalLateUs;
+  };
+  
+  Timer timers[EVENT_TIMER_MAX];
+  uint8_t timerCount;
+  TaskHandle_t task;
+  uint16_t pollMs;
+  uint32_t wakeups;
+  uint32_t eventWakeups;   // woken by a notification, not a timeout
+  
+  uint32_t msUntilNextTimer() const;
+  
+public:
+  static constexpr uint8_t NO_TIMER = 0xFF;
+  
+  EventLoop();
+  void begin();   // binds the calling task - call from setup()
+  
+  // Wake the loop task early
+  void wake();
+  void IRAM_ATTR wakeFromISR();
+  
+  // Timers - addTimer returns NO_TIMER once all EVENT_TIMER_MAX are taken
+  uint8_t addTimer(const char* name, uint32_t periodMs, TimerCallback callback);
+  void setPeriod(uint8_t timer, uint32_t periodMs);   // fires on the next run, then every periodMs
+  void setPollInterval(uint16_t ms);
+  
+  void run();                              // fires every due timer
+  void wait(uint32_t limitMs = UINT32_MAX);  // sleeps until woken, a timer is due or limitMs passed
+  
+  void logStats();
+  void resetStats();
+};
+
+extern EventLoop eventLoop;
@@ -1,32 +1,42 @@
 #pragma once
 #include <Arduino.h>
-#include <Bounce2.h>
 #include "config.h"
 #include "protocol.h"
-
-// Button press detection
-class ButtonHandler {
-private:
-  Bounce& button;
-  uint32_t lastButtonPress;
-  bool buttonHeld;
-  
-public:
-  ButtonHandler(Bounce& btn);
-  ButtonPress checkButtonPress();
-};
+#include "wire_codec.h"
+#include "event_loop.h"
+#include "button_input.h"
 
 // Game phase management
 class GameManager {
 private:
   uint32_t celebrationStart = 0;
-  uint32_t lastPingTime = 0;
+  uint32_t celebrationFrame = UINT32_MAX;  // last rainbow frame drawn
+  uint8_t frameTimer = EventLoop::NO_TIMER;      // LED frame timer, period follows the phase
+  Phase framePhase = Phase::BOOT;  // phase the frame timer is set up for
+  bool stateDirty = false;   // publishes held until flushPublishes()
+  bool queueDirty = false;
+  bool deltaPending = false;
+  Wire::QueueOp pendingOp = Wire::QueueOp::PUSH;
+  uint8_t pendingPosition = 0;
+  
+  // State and queue sequence - epoch tells clients the server rebooted
+  uint16_t epoch = (uint16_t)esp_random();
+  uint16_t sequence = 0;
+  uint16_t queueSequence = 0;  // last queue sent, base for the next delta
+  
+  void sendGameState();
+  void sendBuzzQueue();
+  void sendQueueDelta();
   
 public:
-  void handleButtonPress(ButtonPress press);
-  void handlePhase();
+  void begin();   // LED frame timer and BOOT timeout - after eventLoop.begin()
+  void handleButtonEvent(const ButtonEvent& event);
+  void advancePhase();   // LOBBY -> READY -> question
+  void handlePhase();    // re-times the LED frames after a phase change
+  void renderPhase();    // one LED frame of the current phase
   void resetGame();
   void startQuestion();
+  void openQuestion();   // ARMED -> OPEN at the announced instant
   void nextClient();
   void correctAnswer();
   void resetToReady(); // Helper function
@@ -35,12 +45,15 @@ public:
   void handleClientPing(const String& payload);
   void checkClientTimeouts();
   void publishAnnounce();
-  void publishGameState();
+  void publishGameState();   // sent once at the end of the loop tick
   void publishBuzzQueue();
+  void publishQueueDelta(Wire::QueueOp op, uint8_t position);  // single push/pop this tick
+  void flushPublishes();
+  uint16_t stateEpoch() const;
+  uint16_t stateSequence() const;
   void sendClientAssignment(const String& clientId, uint8_t slot, const Rgb& color);
-  void sendPingToAllClients(); // New ping function
+  void sendPingToAllClients(); // every PING_INTERVAL_MS from the event loop
 };
 
 // Global instances
-extern ButtonHandler* buttonHandler;
 extern GameManager* gameManager;
@@ -0,0 +1,12 @@
+#pragma once
+#include <Arduino.h>
+
+// Heap allocation counter for one task
+// Built with HEAP_COUNTER (env:client_heapcount) malloc/calloc/realloc are
+// wrapped at link time and every allocation made by the watched task is
+// counted. Without it count() stays 0 and nothing is wrapped.
+namespace HeapCounter {
+  void watchCurrentTask();   // Count allocations of the calling task
+  uint32_t count();          // Allocations so far
+  bool isEnabled();
+}
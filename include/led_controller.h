@@ -23,7 +23,7 @@ public:
   void clearQueueLEDs();
   void updateServerLEDs();
   
-  // Animation functions
+  // Animation functions - one step per call, paced by the LED frame timer
   void animateLobby();
   void animateReadyPingPong();
   void testQueueDisplay();
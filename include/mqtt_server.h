@@ -3,18 +3,52 @@
 #include <PicoMQTT.h>
 #include "config.h"
 #include "protocol.h"
+#include "clock_sync.h"
+#include "wire_codec.h"
+#include "buzz_queue.h"
+#include "network_task.h"
 
 // Game Client Structure
+// Clients are interned on join - everything after the join works on their
+// index into gameClients, the wire ID is only looked up once per message
+constexpr uint8_t NO_CLIENT = 0xFF;
+
 struct ClientInfo {
-  String id;
+  char id[WIRE_ID_MAX + 1];
   uint8_t slot;
   Rgb color;
   bool connected;
-  bool buzzed;
   uint32_t lastSeen;
+  ClockSync clock;     // client clock offset/RTT from ping round-trips
+  uint32_t buzzTime;   // press time converted to server clock
+  uint16_t lastBuzzSeq; // highest buzz sequence seen (retransmit dedup)
+  Wire::Codec codec;    // negotiated on join from the client firmware version
+  char assignTopic[WIRE_TOPIC_MAX];  // directed topics, built once on join
+  char ackTopic[WIRE_TOPIC_MAX];
+  char syncTopic[WIRE_TOPIC_MAX];
+  char cmdTopic[WIRE_TOPIC_MAX];
+  bool directCommands;  // listens on its own cmdTopic (firmware >= DIRECT_COMMAND_FIRMWARE)
+  bool batchCommands;   // unpacks batched frames (firmware >= BATCH_FIRMWARE)
+  bool queueDeltas;     // applies queue deltas (firmware >= QUEUE_DELTA_FIRMWARE)
+  bool snapshots;       // restores a reconnect from a snapshot (firmware >= SNAPSHOT_FIRMWARE)
+};
+
+// Command bytes on air over a question round - what went out, and what the
+// same commands would have cost broadcast to every client
+struct AirStats {
+  uint16_t frames;
+  uint32_t bytes;
+  uint32_t broadcastBytes;
+};
+
+// Preallocated outbound payload buffer
+struct OutboundBuffer {
+  uint8_t data[WIRE_FRAME_MAX];
+  size_t length;
+  bool inUse;
 };
 
-// Custom MQTT Broker class
+// Custom MQTT Broker class - runs in the network task only
 class QuizMQTTBroker : public PicoMQTT::Server {
 public:
   void on_connected(const char * client_id) override;
@@ -22,25 +56,72 @@ public:
 };
 
 // MQTT Message Handlers
-void handleClientJoin(const String& payload);
-void handleClientBuzz(const String& payload);
-void handleClientPing(const String& payload);
+// Payloads in either wire encoding
+void handleClientJoin(const uint8_t* payload, size_t length);
+void handleClientBuzz(const uint8_t* payload, size_t length);
+void handleClientPing(const uint8_t* payload, size_t length);
+
+// Buzz arbitration window (first buzz opens it, loop closes it)
+void processBuzzWindow();
+uint32_t msUntilBuzzWindowCloses();   // UINT32_MAX while no window is open
+void closeBuzzWindow();
+void cancelBuzzWindow();
+
+// Wire ID to gameClients index, NO_CLIENT if not joined
+uint8_t lookupClient(const char* clientId);
 
 // MQTT Publishers
-void sendClientAssignment(const String& clientId, uint8_t slot, const Rgb& color);
+void sendClientAssignment(const char* clientId, uint8_t slot, const Rgb& color);
+void sendClientSnapshot(const ClientInfo& client);
+void sendClockSync(const char* clientId, uint32_t clientTime, uint32_t serverTime);
+void sendBuzzAck(const char* clientId, uint8_t position, uint32_t receiveTime, uint32_t pressTime, uint16_t seq,
+                 bool falseStart = false);
+Wire::CommandMessage makeCommand(CommandType cmd, const char* target = "");
+void publishCommand(const Wire::CommandMessage& msg);  // queued until flushOutbound()
+void flushCommands();
+void flushOutbound();
+Wire::Codec broadcastCodec();
+bool broadcastQueueDeltas();
+void resetAirStats();
+void logAirStats();
 void publishGameState();
 void publishBuzzQueue();
 void publishAnnounce();
 
+// Outbound buffer pool
+OutboundBuffer* acquireOutbound();
+void releaseOutbound(OutboundBuffer* buffer);
+
+// Heap-free replacement for Serial.printf (loop task only)
+void logPrintf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
 // Client Timeout Management
 void checkClientTimeouts();
 
-// Global variables (declared in mqtt_server.cpp)
+// Global variables (declared in mqtt_server.cpp) - game state is owned by the
+// loop task, the network task never touches it
 extern QuizMQTTBroker mqttBroker;
 extern ClientInfo gameClients[MAX_CLIENTS];
 extern uint8_t gameClientCount;
-extern String buzzQueue[MAX_CLIENTS];
-extern uint8_t queueLength;
+extern BuzzQueue buzzQueue;
 extern int8_t activeClientIndex;
 extern Phase currentPhase;
+extern uint32_t questionOpenTime;  // announced open instant of the current question
+extern uint32_t questionArmTime;   // when the current question was armed
 extern bool gameLocked;
+
+// Encode a message into a pool buffer and queue it for the broker - payload
+// length, 0 if not sent
+template <typename Message>
+size_t publishMessage(const char* topic, const Message& msg, Wire::Codec codec, bool retain = false) {
+  OutboundBuffer* buffer = acquireOutbound();
+  if (!buffer) return 0;
+  
+  buffer->length = Wire::encode(msg, codec, buffer->data, sizeof(buffer->data));
+  size_t sent = 0;
+  if (buffer->length > 0 && postOutbound(topic, buffer->data, buffer->length, retain)) {
+    sent = buffer->length;
+  }
+  releaseOutbound(buffer);
+  return sent;
+}
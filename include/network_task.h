@@ -0,0 +1,28 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "protocol.h"
+
+// Server network task
+//
+// The PicoMQTT broker runs alone in its own task pinned to NETWORK_TASK_CORE.
+// Game logic, buttons and LED output stay in the Arduino loop task on the
+// other core and own all game state (gameClients, buzzQueue, currentPhase).
+// The two only meet in two lock-free SPSC queues:
+//  - inbound: received messages (topic, payload, receive time), drained by
+//    processInbound() in the loop task - wakes the event loop on arrival
+//  - outbound: publishes from the loop task, handed to the broker by the
+//    network task - postOutbound() wakes it
+// Nothing else may touch mqttBroker once the task runs.
+
+// Subscribes every topic with a handler, starts the broker and the task
+void startNetworkTask(const MessageHandler* handlers);
+
+// Loop task side
+void processInbound(const MessageHandler* handlers);   // runs the handlers of every received message
+uint32_t inboundReceiveTime();   // millis() the message being handled arrived at the broker
+bool postOutbound(const char* topic, const uint8_t* data, size_t length, bool retain);  // false if dropped
+void setNetworkPollInterval(uint16_t ms);
+
+// Broker loop gaps and queue drops since the last call
+void logNetworkStats();
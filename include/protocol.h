@@ -7,16 +7,35 @@ namespace Topic {
   constexpr auto ASSIGN = "quiz/assign/";  // + clientId
   constexpr auto STATE = "quiz/state";
   constexpr auto BUZZ = "quiz/buzz";
+  constexpr auto ACK = "quiz/ack/";        // + clientId
+  constexpr auto SYNC = "quiz/sync/";      // + clientId
   constexpr auto QUEUE = "quiz/queue";
-  constexpr auto CMD = "quiz/cmd";
+  constexpr auto CMD = "quiz/cmd";         // broadcast commands
+  constexpr auto CLIENT_CMD = "quiz/cmd/"; // + clientId, directed commands
   constexpr auto PING = "quiz/ping";
 }
 
+// Topic IDs - order matches TOPIC_ROUTES below
+enum class TopicId : uint8_t {
+  ANNOUNCE = 0,
+  JOIN,
+  ASSIGN,
+  STATE,
+  BUZZ,
+  ACK,
+  SYNC,
+  QUEUE,
+  CMD,
+  PING,
+  UNKNOWN
+};
+
 // Game State Phases
 enum class Phase : uint8_t {
   BOOT = 0,
   LOBBY,    // Waiting for clients, join allowed
   READY,    // Min clients reached, locked, ready for question
+  ARMED,    // Question announced, opens at the announced hub time
   OPEN,     // Question open, buzz allowed
   ANSWER,   // Someone buzzed, processing answers
   RESET     // Question finished, celebrating/resetting
@@ -39,7 +58,9 @@ enum class ButtonPress : uint8_t {
   NONE = 0,
   SHORT,      // < 600ms
   LONG,       // >= 1200ms
-  VERY_LONG   // >= 4000ms
+  VERY_LONG,  // >= 4000ms
+  NEXT,       // Server NEXT button - wrong answer
+  CORRECT     // Server CORRECT button - correct answer / advance
 };
 
 // LED Animation Types
@@ -60,14 +81,34 @@ namespace Command {
   constexpr auto CELEBRATE = "CELEBRATE";
   constexpr auto WRONG_FLASH = "WRONG_FLASH";
   constexpr auto RESET = "RESET";
+  constexpr auto PING_REQUEST = "PING_REQUEST";
 }
 
+// Command codes (binary wire codec)
+enum class CommandType : uint8_t {
+  NONE = 0,
+  LIGHT_WHITE,
+  ANIM_ACTIVE,
+  IDLE_COLOR,
+  CELEBRATE,
+  WRONG_FLASH,
+  RESET,
+  PING_REQUEST
+};
+
 // JSON Message Keys
 namespace JsonKey {
   // Common
   constexpr auto ID = "id";
   constexpr auto VERSION = "version";
   constexpr auto TIMESTAMP = "t";
+  constexpr auto SEQUENCE = "seq";
+  constexpr auto EPOCH = "ep";     // Server boot epoch of a state sequence
+  constexpr auto HUB_TIME = "ht";  // Timestamp already in server (hub) clock
+  constexpr auto FALSE_START = "fs"; // Pressed before the question opened
+  
+  // Ping
+  constexpr auto ECHO = "echo";  // Server ping time echoed back by client
   
   // Announce
   constexpr auto MAX_CLIENTS = "maxClients";
@@ -83,6 +124,10 @@ namespace JsonKey {
   
   // State
   constexpr auto PHASE = "phase";
+  constexpr auto OPEN_AT = "openAt";   // Question open instant (hub time)
+  
+  // Buzz Ack
+  constexpr auto POSITION = "pos";
   
   // Queue
   constexpr auto ORDER = "order";
@@ -91,17 +136,32 @@ namespace JsonKey {
   // Command
   constexpr auto CMD = "cmd";
   constexpr auto TARGET = "target";
+  constexpr auto START = "start";   // Effect start instant (hub time)
 }
 
 // Protocol Version
 constexpr auto PROTOCOL_VERSION = "1.0";
 
+// Client firmware version sent on join - from BINARY_CODEC_FIRMWARE on the
+// client also speaks the binary wire codec (see wire_codec.h), from
+// DIRECT_COMMAND_FIRMWARE on it listens on its own Topic::CLIENT_CMD, from
+// BATCH_FIRMWARE on it unpacks batched binary frames, from
+// QUEUE_DELTA_FIRMWARE on it applies queue deltas, from SNAPSHOT_FIRMWARE on
+// it restores a reconnect from one snapshot
+constexpr auto FIRMWARE_VERSION = "1.5";
+constexpr auto BINARY_CODEC_FIRMWARE = "1.1";
+constexpr auto DIRECT_COMMAND_FIRMWARE = "1.2";
+constexpr auto BATCH_FIRMWARE = "1.3";
+constexpr auto QUEUE_DELTA_FIRMWARE = "1.4";
+constexpr auto SNAPSHOT_FIRMWARE = "1.5";
+
 // Utility Functions for Phase Names
 inline const char* phaseToString(Phase phase) {
   switch(phase) {
     case Phase::BOOT: return "BOOT";
     case Phase::LOBBY: return "LOBBY";
     case Phase::READY: return "READY";
+    case Phase::ARMED: return "ARMED";
     case Phase::OPEN: return "OPEN";
     case Phase::ANSWER: return "ANSWER";
     case Phase::RESET: return "RESET";
@@ -109,13 +169,152 @@ inline const char* phaseToString(Phase phase) {
   }
 }
 
+inline const char* buttonPressToString(ButtonPress press) {
+  switch(press) {
+    case ButtonPress::SHORT: return "SHORT";
+    case ButtonPress::LONG: return "LONG";
+    case ButtonPress::VERY_LONG: return "VERY LONG";
+    case ButtonPress::NEXT: return "NEXT";
+    case ButtonPress::CORRECT: return "CORRECT";
+    default: return "NONE";
+  }
+}
+
 inline Phase stringToPhase(const char* str) {
   if (strcmp(str, "BOOT") == 0) return Phase::BOOT;
   if (strcmp(str, "LOBBY") == 0) return Phase::LOBBY;
   if (strcmp(str, "READY") == 0) return Phase::READY;
+  if (strcmp(str, "ARMED") == 0) return Phase::ARMED;
   if (strcmp(str, "OPEN") == 0) return Phase::OPEN;
   if (strcmp(str, "ANSWER") == 0) return Phase::ANSWER;
   if (strcmp(str, "RESET") == 0) return Phase::RESET;
   return Phase::BOOT;
 }
 
+
+// Compile-time topic and command routing
+//
+// Topics and command names map to their enum through a perfect hash built at
+// compile time: the hash picks a slot in a 16-entry table and a single string
+// compare confirms the hit. Adding a topic or command that collides fails the
+// build at the static_assert below - adjust the hash if that happens.
+
+// Handler signature for dispatch tables indexed by TopicId
+typedef void (*MessageHandler)(const uint8_t* payload, size_t length);
+
+constexpr uint8_t ROUTE_HASH_SIZE = 16;
+constexpr uint8_t TOPIC_ROOT_LENGTH = 5;  // "quiz/"
+constexpr uint8_t TOPIC_COUNT = (uint8_t)TopicId::UNKNOWN;
+constexpr uint8_t COMMAND_COUNT = (uint8_t)CommandType::PING_REQUEST + 1;
+
+constexpr uint8_t constLength(const char* str) {
+  return *str ? 1 + constLength(str + 1) : 0;
+}
+
+struct TopicRoute {
+  const char* name;
+  uint8_t length;
+  bool prefix;  // Directed topic, clientId follows the name
+};
+
+// Order matches TopicId
+constexpr TopicRoute TOPIC_ROUTES[TOPIC_COUNT] = {
+  { Topic::ANNOUNCE, constLength(Topic::ANNOUNCE), false },
+  { Topic::JOIN, constLength(Topic::JOIN), false },
+  { Topic::ASSIGN, constLength(Topic::ASSIGN), true },
+  { Topic::STATE, constLength(Topic::STATE), false },
+  { Topic::BUZZ, constLength(Topic::BUZZ), false },
+  { Topic::ACK, constLength(Topic::ACK), true },
+  { Topic::SYNC, constLength(Topic::SYNC), true },
+  { Topic::QUEUE, constLength(Topic::QUEUE), false },
+  { Topic::CMD, constLength(Topic::CMD), true },     // also quiz/cmd/<clientId>
+  { Topic::PING, constLength(Topic::PING), false }
+};
+
+// Order matches CommandType, NONE has no name
+constexpr const char* COMMAND_NAMES[COMMAND_COUNT] = {
+  "",
+  Command::LIGHT_WHITE,
+  Command::ANIM_ACTIVE,
+  Command::IDLE_COLOR,
+  Command::CELEBRATE,
+  Command::WRONG_FLASH,
+  Command::RESET,
+  Command::PING_REQUEST
+};
+
+// The two characters after "quiz/" tell every topic apart
+constexpr uint8_t topicHash(const char* topic) {
+  return ((uint8_t)topic[TOPIC_ROOT_LENGTH] + ((uint8_t)topic[TOPIC_ROOT_LENGTH + 1] >> 1)) & (ROUTE_HASH_SIZE - 1);
+}
+
+// Command names differ in their first character
+constexpr uint8_t commandHash(const char* name) {
+  return (uint8_t)name[0] & (ROUTE_HASH_SIZE - 1);
+}
+
+// Slot tables: hash slot -> index, COUNT for empty slots
+constexpr uint8_t topicForSlot(uint8_t slot, uint8_t index = 0) {
+  return index >= TOPIC_COUNT ? TOPIC_COUNT
+       : topicHash(TOPIC_ROUTES[index].name) == slot ? index
+       : topicForSlot(slot, index + 1);
+}
+
+constexpr uint8_t commandForSlot(uint8_t slot, uint8_t index = 1) {
+  return index >= COMMAND_COUNT ? COMMAND_COUNT
+       : commandHash(COMMAND_NAMES[index]) == slot ? index
+       : commandForSlot(slot, index + 1);
+}
+
+// Perfect = every entry is the one its slot resolves to
+constexpr bool topicHashIsPerfect(uint8_t index = 0) {
+  return index >= TOPIC_COUNT
+      || (topicForSlot(topicHash(TOPIC_ROUTES[index].name)) == index && topicHashIsPerfect(index + 1));
+}
+
+constexpr bool commandHashIsPerfect(uint8_t index = 1) {
+  return index >= COMMAND_COUNT
+      || (commandForSlot(commandHash(COMMAND_NAMES[index])) == index && commandHashIsPerfect(index + 1));
+}
+
+static_assert(topicHashIsPerfect(), "topicHash() collides - pick other topic characters");
+static_assert(commandHashIsPerfect(), "commandHash() collides - pick another command character");
+
+constexpr uint8_t TOPIC_SLOTS[ROUTE_HASH_SIZE] = {
+  topicForSlot(0), topicForSlot(1), topicForSlot(2), topicForSlot(3),
+  topicForSlot(4), topicForSlot(5), topicForSlot(6), topicForSlot(7),
+  topicForSlot(8), topicForSlot(9), topicForSlot(10), topicForSlot(11),
+  topicForSlot(12), topicForSlot(13), topicForSlot(14), topicForSlot(15)
+};
+
+constexpr uint8_t COMMAND_SLOTS[ROUTE_HASH_SIZE] = {
+  commandForSlot(0), commandForSlot(1), commandForSlot(2), commandForSlot(3),
+  commandForSlot(4), commandForSlot(5), commandForSlot(6), commandForSlot(7),
+  commandForSlot(8), commandForSlot(9), commandForSlot(10), commandForSlot(11),
+  commandForSlot(12), commandForSlot(13), commandForSlot(14), commandForSlot(15)
+};
+
+// Topic to ID with one hash and one compare, UNKNOWN if not ours
+inline TopicId topicToId(const char* topic) {
+  if (strncmp(topic, Topic::ANNOUNCE, TOPIC_ROOT_LENGTH) != 0 || topic[TOPIC_ROOT_LENGTH] == '\0') {
+    return TopicId::UNKNOWN;
+  }
+  uint8_t index = TOPIC_SLOTS[topicHash(topic)];
+  if (index >= TOPIC_COUNT) return TopicId::UNKNOWN;
+
+  const TopicRoute& route = TOPIC_ROUTES[index];
+  bool match = route.prefix ? strncmp(topic, route.name, route.length) == 0
+                            : strcmp(topic, route.name) == 0;
+  return match ? (TopicId)index : TopicId::UNKNOWN;
+}
+
+// Utility Functions for Command Names
+inline const char* commandToString(CommandType cmd) {
+  return (uint8_t)cmd < COMMAND_COUNT ? COMMAND_NAMES[(uint8_t)cmd] : "";
+}
+
+inline CommandType stringToCommand(const char* str) {
+  uint8_t index = COMMAND_SLOTS[commandHash(str)];
+  if (index >= COMMAND_COUNT || strcmp(str, COMMAND_NAMES[index]) != 0) return CommandType::NONE;
+  return (CommandType)index;
+}
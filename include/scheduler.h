@@ -0,0 +1,38 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// Deferred actions for the server loop - "do X in N ms" without blocking the
+// broker. Pending actions sit in a min-heap on their due time, run() fires
+// the due ones once per loop tick.
+typedef void (*DeferredAction)(uint8_t arg);
+
+class Scheduler {
+private:
+  struct Entry {
+    uint32_t due;
+    DeferredAction action;
+    uint8_t arg;
+  };
+  
+  Entry heap[SCHEDULER_CAPACITY];
+  uint8_t count;
+  
+  void siftUp(uint8_t index);
+  void siftDown(uint8_t index);
+  void removeAt(uint8_t index);
+  
+public:
+  Scheduler();
+  
+  bool at(uint32_t due, DeferredAction action, uint8_t arg = 0);  // false if full
+  bool after(uint32_t delayMs, DeferredAction action, uint8_t arg = 0);
+  void cancel(DeferredAction action);   // drops every pending run of action
+  bool isPending(DeferredAction action) const;
+  uint8_t size() const;
+  uint32_t msUntilNext() const;   // 0 if due, UINT32_MAX if nothing pending
+  
+  void run();   // fires every due action, earliest first
+};
+
+extern Scheduler scheduler;
@@ -0,0 +1,44 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+// Single-producer single-consumer ring between two tasks (or cores) - one
+// side only pushes, the other only pops, no locks. Slots are filled and read
+// in place: the producer writes slotToFill() and then push()es it, the
+// consumer reads front() and then pop()s it.
+template <typename T, uint8_t N>
+class SpscQueue {
+private:
+  static_assert(N > 0 && N <= 128 && (N & (N - 1)) == 0, "queue size must be a power of 2 up to 128");
+  
+  T slots[N];
+  std::atomic<uint8_t> head;   // next slot to read, advanced by the consumer
+  std::atomic<uint8_t> tail;   // next slot to write, advanced by the producer
+  
+public:
+  SpscQueue() : head(0), tail(0) {}
+  
+  // Producer side - nullptr while full
+  T* slotToFill() {
+    uint8_t t = tail.load(std::memory_order_relaxed);
+    if ((uint8_t)(t - head.load(std::memory_order_acquire)) == N) return nullptr;
+    return &slots[t & (N - 1)];
+  }
+  void push() {
+    tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+  
+  // Consumer side - nullptr while empty
+  T* front() {
+    uint8_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) return nullptr;
+    return &slots[h & (N - 1)];
+  }
+  void pop() {
+    head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+  
+  uint8_t size() const {
+    return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+  }
+};
@@ -0,0 +1,231 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "protocol.h"
+
+// Wire codec shared by server and client firmware
+//
+// Every topic payload is a message struct below, encoded either as JSON
+// (protocol 1.0, understood by all firmware) or as packed binary. Binary is
+// negotiated per client on join: the client announces its firmware version
+// (JsonKey::FIRMWARE), the server answers the assignment in binary if that
+// version speaks it, and the client only switches its own messages to binary
+// once such an assignment arrived. Broadcast topics go out in binary only
+// while every joined client negotiated it. Join and announce stay JSON.
+//
+// Decoders accept both encodings - binary payloads start with
+// WIRE_BINARY_MAGIC, JSON ones with '{'.
+//
+// Binary layout: magic, message type, fields in struct order. Integers are
+// little-endian, strings are a length byte followed by the characters.
+//
+// A batch (binary only, firmware >= BATCH_FIRMWARE) carries several binary
+// frames for the same topic in one publish: magic, BATCH, then each frame
+// prefixed by its length byte.
+namespace Wire {
+
+enum class Codec : uint8_t {
+  JSON = 0,
+  BINARY
+};
+
+enum class MessageType : uint8_t {
+  ASSIGN = 1,
+  STATE,
+  QUEUE,
+  CMD,
+  ACK,
+  SYNC,
+  BUZZ,
+  PING,
+  BATCH,
+  QUEUE_DELTA,
+  SNAPSHOT
+};
+
+enum class QueueOp : uint8_t {
+  PUSH = 1,   // id inserted at position
+  POP         // entry at position removed
+};
+
+// Flag bits in binary messages
+namespace Flag {
+  constexpr uint8_t LOCKED = 0x01;       // state
+  constexpr uint8_t OPEN_AT = 0x02;      // state
+  constexpr uint8_t START = 0x01;        // cmd
+  constexpr uint8_t TIMESTAMP = 0x02;    // cmd, buzz, ping
+  constexpr uint8_t FALSE_START = 0x04;  // ack, buzz
+  constexpr uint8_t HUB_TIME = 0x08;     // buzz
+  constexpr uint8_t ECHO = 0x10;         // ping
+  constexpr uint8_t SEQUENCE = 0x20;     // state
+  constexpr uint8_t ACTIVE = 0x40;       // snapshot
+}
+
+// Join (JSON only - carries the negotiation)
+struct JoinMessage {
+  char id[WIRE_ID_MAX + 1];
+  uint8_t capability;
+  char firmware[8];
+};
+
+// Announce (JSON only - retained, read before joining)
+struct AnnounceMessage {
+  uint8_t maxClients;
+  bool locked;
+};
+
+struct AssignMessage {
+  uint8_t slot;
+  Rgb color;
+};
+
+// State and queue share one sequence per server epoch (random per boot),
+// so clients can drop updates that arrive out of order. Messages from older
+// servers have no sequence.
+struct StateMessage {
+  Phase phase;
+  bool locked;
+  bool hasOpenAt;
+  uint32_t openAt;
+  uint8_t clientCount;
+  bool hasSequence;
+  uint16_t epoch;
+  uint16_t seq;
+};
+
+struct QueueMessage {
+  uint8_t length;
+  int8_t active;    // index into order, -1 = nobody answering
+  char order[MAX_CLIENTS][WIRE_ID_MAX + 1];
+  bool hasSequence;
+  uint16_t epoch;
+  uint16_t seq;
+};
+
+// Queue delta (binary only, firmware >= QUEUE_DELTA_FIRMWARE) - one push or
+// pop on the queue as of sequence base, sent on Topic::QUEUE
+struct QueueDeltaMessage {
+  uint16_t epoch;
+  uint16_t seq;
+  uint16_t base;
+  QueueOp op;
+  uint8_t position;
+  int8_t active;    // index after the change, -1 = nobody answering
+  char id[WIRE_ID_MAX + 1];  // PUSH only
+};
+
+struct CommandMessage {
+  CommandType cmd;
+  char target[WIRE_ID_MAX + 1];  // empty = all clients
+  bool hasStart;
+  uint32_t start;
+  bool hasTimestamp;
+  uint32_t timestamp;
+};
+
+struct AckMessage {
+  uint8_t position;
+  uint32_t receiveTime;
+  uint32_t pressTime;   // echo of the buzz timestamp
+  uint16_t seq;         // 0 = no sequence
+  bool falseStart;
+};
+
+struct SyncMessage {
+  uint32_t echo;
+  uint32_t serverTime;
+};
+
+struct BuzzMessage {
+  char id[WIRE_ID_MAX + 1];
+  uint16_t seq;         // 0 = client without retransmit
+  bool hasTimestamp;
+  bool hubTime;         // timestamp already in hub clock (offline buzz)
+  uint32_t timestamp;
+  bool falseStart;
+};
+
+struct PingMessage {
+  char id[WIRE_ID_MAX + 1];
+  bool hasTimestamp;
+  uint32_t timestamp;
+  bool hasEcho;
+  uint32_t echo;
+};
+
+// Snapshot (binary only, firmware >= SNAPSHOT_FIRMWARE) - everything a
+// reconnecting client needs in one message, sent on its assign topic in
+// place of the assignment and the restore commands
+struct SnapshotMessage {
+  uint8_t slot;
+  Rgb color;
+  Phase phase;
+  bool locked;
+  bool hasOpenAt;
+  uint32_t openAt;
+  uint8_t position;   // 1-based queue position, 0 = not queued
+  bool active;        // answering right now
+  uint16_t epoch;
+  uint16_t seq;       // last state/queue sequence the snapshot covers
+};
+
+// Binary buzz frame field offsets for an ID of the given length, so the
+// client can patch a pre-built frame in place
+inline uint8_t buzzSeqOffset(uint8_t idLength) { return 3 + idLength; }
+inline uint8_t buzzFlagsOffset(uint8_t idLength) { return 5 + idLength; }
+inline uint8_t buzzTimeOffset(uint8_t idLength) { return 6 + idLength; }
+
+inline bool isBinary(const uint8_t* payload, size_t length) {
+  return length >= 2 && payload[0] == WIRE_BINARY_MAGIC;
+}
+
+inline bool isBatch(const uint8_t* payload, size_t length) {
+  return isBinary(payload, length) && payload[1] == (uint8_t)MessageType::BATCH;
+}
+
+inline bool isSnapshot(const uint8_t* payload, size_t length) {
+  return isBinary(payload, length) && payload[1] == (uint8_t)MessageType::SNAPSHOT;
+}
+
+inline bool isQueueDelta(const uint8_t* payload, size_t length) {
+  return isBinary(payload, length) && payload[1] == (uint8_t)MessageType::QUEUE_DELTA;
+}
+
+bool firmwareAtLeast(const char* firmware, const char* minimum);
+bool firmwareSupportsBinary(const char* firmware);
+
+// Encoders write into out and return the payload length, 0 if it didn't fit
+size_t encode(const JoinMessage& msg, uint8_t* out, size_t capacity);
+size_t encode(const AnnounceMessage& msg, uint8_t* out, size_t capacity);
+size_t encode(const AssignMessage& msg, Codec codec, uint8_t* out, size_t capacity);
+size_t encode(const StateMessage& msg, Codec codec, uint8_t* out, size_t capacity);
+size_t encode(const QueueMessage& msg, Codec codec, uint8_t* out, size_t capacity);
+size_t encode(const CommandMessage& msg, Codec codec, uint8_t* out, size_t capacity);
+size_t encode(const AckMessage& msg, Codec codec, uint8_t* out, size_t capacity);
+size_t encode(const SyncMessage& msg, Codec codec, uint8_t* out, size_t capacity);
+size_t encode(const BuzzMessage& msg, Codec codec, uint8_t* out, size_t capacity);
+size_t encode(const PingMessage& msg, Codec codec, uint8_t* out, size_t capacity);
+size_t encode(const QueueDeltaMessage& msg, uint8_t* out, size_t capacity);
+size_t encode(const SnapshotMessage& msg, uint8_t* out, size_t capacity);
+
+// Batches - beginBatch returns the empty batch length, appendToBatch the new
+// length (0 if the frame doesn't fit). nextBatchFrame walks the frames from
+// offset 0, false once done or on a malformed batch.
+size_t beginBatch(uint8_t* out, size_t capacity);
+size_t appendToBatch(uint8_t* batch, size_t length, size_t capacity, const uint8_t* frame, size_t frameLength);
+bool nextBatchFrame(const uint8_t* batch, size_t length, size_t& offset, const uint8_t*& frame, size_t& frameLength);
+
+// Decoders take either encoding, false on malformed payloads
+bool decode(const uint8_t* payload, size_t length, JoinMessage& msg);
+bool decode(const uint8_t* payload, size_t length, AssignMessage& msg);
+bool decode(const uint8_t* payload, size_t length, StateMessage& msg);
+bool decode(const uint8_t* payload, size_t length, QueueMessage& msg);
+bool decode(const uint8_t* payload, size_t length, CommandMessage& msg);
+bool decode(const uint8_t* payload, size_t length, AckMessage& msg);
+bool decode(const uint8_t* payload, size_t length, SyncMessage& msg);
+bool decode(const uint8_t* payload, size_t length, BuzzMessage& msg);
+bool decode(const uint8_t* payload, size_t length, PingMessage& msg);
+bool decode(const uint8_t* payload, size_t length, QueueDeltaMessage& msg);
+bool decode(const uint8_t* payload, size_t length, SnapshotMessage& msg);
+
+}
@@ -0,0 +1,100 @@
+#include "button_debounce.h"
+
+constexpr int64_t DEBOUNCE_US = (int64_t)DEBOUNCE_MS * 1000;
+
+ButtonDebouncer::ButtonDebouncer(DebounceMode debounceMode)
+  : mode(debounceMode), lockState(LockState::ARMED), lockStartUs(0),
+    stableDown(false), rawDown(false), rawChangedUs(0),
+    pressTimeUs(0), pressed(false), edgeTimeUs(0), edgeCaptured(false) {
+}
+
+void IRAM_ATTR ButtonDebouncer::captureEdge(bool down, int64_t timeUs) {
+  // Keep the first edge only - contact chatter must not move the press time.
+  // A pin already back HIGH was a glitch, not a contact.
+  if (!edgeCaptured && down) {
+    edgeTimeUs = timeUs;
+    edgeCaptured = true;
+  }
+}
+
+void ButtonDebouncer::update(bool down, int64_t nowUs) {
+  if (mode == DebounceMode::LOCK_OUT) {
+    updateLockOut(down, nowUs);
+  } else {
+    updateStable(down, nowUs);
+  }
+}
+
+void ButtonDebouncer::updateStable(bool down, int64_t nowUs) {
+  // Any change restarts the settle time
+  if (down != rawDown) {
+    rawDown = down;
+    rawChangedUs = nowUs;
+    return;
+  }
+  if (down == stableDown || nowUs - rawChangedUs < DEBOUNCE_US) return;
+
+  stableDown = down;
+  if (down) {
+    // Use the interrupt edge - fall back to now if it was missed
+    registerPress(edgeCaptured ? edgeTimeUs : nowUs);
+  }
+  // Press consumed or release chatter over - re-arm the slot for the next press
+  edgeCaptured = false;
+}
+
+void ButtonDebouncer::updateLockOut(bool down, int64_t nowUs) {
+  switch (lockState) {
+    case LockState::ARMED:
+      // Fire on the first edge - no waiting for the contact to settle
+      if (edgeCaptured) {
+        registerPress(edgeTimeUs);
+        lockState = LockState::PRESSED;
+        lockStartUs = edgeTimeUs;
+      } else if (down) {
+        // Edge interrupt missed - the level still tells us it's pressed
+        registerPress(nowUs);
+        lockState = LockState::PRESSED;
+        lockStartUs = nowUs;
+      }
+      break;
+
+    case LockState::PRESSED:
+      // Ignore all chatter for DEBOUNCE_MS after the press edge
+      if (nowUs - lockStartUs >= DEBOUNCE_US && !down) {
+        lockState = LockState::RELEASING;
+        lockStartUs = nowUs;
+      }
+      break;
+
+    case LockState::RELEASING:
+      if (down) {
+        // Release chatter (or still held) - keep locked
+        lockState = LockState::PRESSED;
+      } else if (nowUs - lockStartUs >= DEBOUNCE_US) {
+        // Stable release - drop edges captured from release chatter and re-arm
+        edgeCaptured = false;
+        lockState = LockState::ARMED;
+      }
+      break;
+  }
+}
+
+void ButtonDebouncer::registerPress(int64_t timeUs) {
+  if (pressed) return; // previous press not consumed yet
+
+  pressed = true;
+  pressTimeUs = timeUs;
+}
+
+bool ButtonDebouncer::wasPressed() {
+  if (pressed) {
+    pressed = false;
+    return true;
+  }
+  return false;
+}
+
+int64_t ButtonDebouncer::getPressTimeUs() const {
+  return pressTimeUs;
+}
@@ -0,0 +1,127 @@
+#include "button_input.h"
+#include "event_loop.h"
+#include <esp_timer.h>
+
+// Global instance
+ButtonInput* buttonInput = nullptr;
+
+const uint8_t ButtonInput::PINS[BUTTON_COUNT] = {BUTTON_PIN, NEXT_BUTTON_PIN, CORRECT_BUTTON_PIN};
+SpscQueue<ButtonInput::Edge, BUTTON_EDGE_QUEUE> ButtonInput::edges;
+
+// All GPIO interrupts share one dispatcher, so the three pins never preempt
+// each other - a single producer for the edge queue. A full queue drops the
+// edge, update() catches up from the pin level.
+void IRAM_ATTR ButtonInput::onEdge(void* arg) {
+  uint8_t button = (uint8_t)(uintptr_t)arg;
+  Edge* edge = edges.slotToFill();
+  if (edge) {
+    edge->button = button;
+    edge->down = digitalRead(PINS[button]) == LOW;
+    edge->time = (uint32_t)(esp_timer_get_time() / 1000); // millis() is esp_timer / 1000
+    edges.push();
+  }
+  eventLoop.wakeFromISR();
+}
+
+ButtonInput::ButtonInput() {
+  for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+    states[i].down = false;
+    states[i].changedAt = 0;
+    states[i].pressedAt = 0;
+    states[i].holdFired = false;
+  }
+}
+
+void ButtonInput::begin() {
+  for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+    pinMode(PINS[i], INPUT_PULLUP);
+    attachInterruptArg(digitalPinToInterrupt(PINS[i]), onEdge, (void*)(uintptr_t)i, CHANGE);
+  }
+}
+
+void ButtonInput::update() {
+  Edge* edge;
+  while ((edge = edges.front()) != nullptr) {
+    applyEdge(edge->button, edge->down, edge->time);
+    edges.pop();
+  }
+  
+  uint32_t now = millis();
+  for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+    // Chatter settled on a level we have no accepted edge for (edge ignored
+    // inside the lock-out, or dropped) - take it from the pin
+    bool down = digitalRead(PINS[i]) == LOW;
+    if (down != states[i].down && now - states[i].changedAt >= DEBOUNCE_MS) {
+      applyEdge(i, down, now);
+    }
+  }
+  
+  State& main = states[MAIN];
+  if (main.down && !main.holdFired && now - main.pressedAt >= VERY_LONG_PRESS_MS) {
+    main.holdFired = true;
+    emit(ButtonPress::VERY_LONG, main.pressedAt);
+  }
+}
+
+// Lock-out debounce - the first edge counts right away, edges within
+// DEBOUNCE_MS after it are contact chatter
+void ButtonInput::applyEdge(uint8_t button, bool down, uint32_t time) {
+  State& state = states[button];
+  if (down == state.down || (int32_t)(time - state.changedAt) < (int32_t)DEBOUNCE_MS) return;
+  state.down = down;
+  state.changedAt = time;
+  
+  if (down) {
+    state.pressedAt = time;
+    state.holdFired = false;
+    if (button == NEXT) {
+      emit(ButtonPress::NEXT, time);
+    } else if (button == CORRECT) {
+      emit(ButtonPress::CORRECT, time);
+    }
+    return;
+  }
+  
+  if (button != MAIN || state.holdFired) return;
+  uint32_t held = time - state.pressedAt;
+  if (held < SHORT_PRESS_MAX_MS) {
+    emit(ButtonPress::SHORT, state.pressedAt);
+  } else if (held >= LONG_PRESS_MS) {
+    emit(ButtonPress::LONG, state.pressedAt);
+  }
+}
+
+void ButtonInput::emit(ButtonPress press, uint32_t pressTime) {
+  ButtonEvent* event = events.slotToFill();
+  if (!event) return;
+  event->press = press;
+  event->pressTime = pressTime;
+  events.push();
+}
+
+bool ButtonInput::nextEvent(ButtonEvent& event) {
+  ButtonEvent* next = events.front();
+  if (!next) return false;
+  event = *next;
+  events.pop();
+  return true;
+}
+
+uint32_t ButtonInput::msUntilDue() const {
+  uint32_t next = UINT32_MAX;
+  uint32_t now = millis();
+  for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+    // A level change inside the lock-out is only seen once it expires
+    if (now - states[i].changedAt < DEBOUNCE_MS) {
+      uint32_t remaining = DEBOUNCE_MS - (now - states[i].changedAt);
+      if (remaining < next) next = remaining;
+    }
+  }
+  const State& main = states[MAIN];
+  if (main.down && !main.holdFired) {
+    uint32_t held = now - main.pressedAt;
+    uint32_t remaining = held < VERY_LONG_PRESS_MS ? VERY_LONG_PRESS_MS - held : 0;
+    if (remaining < next) next = remaining;
+  }
+  return next;
+}
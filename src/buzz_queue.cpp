@@ -0,0 +1,92 @@
+#include "buzz_queue.h"
+
+BuzzQueue::BuzzQueue() {
+  clear();
+}
+
+void BuzzQueue::clear() {
+  head = 0;
+  count = 0;
+  buzzedMask = 0;
+}
+
+uint8_t BuzzQueue::slotOf(uint8_t position) const {
+  uint8_t slot = head + position;
+  return slot >= MAX_CLIENTS ? slot - MAX_CLIENTS : slot;
+}
+
+uint8_t BuzzQueue::size() const {
+  return count;
+}
+
+bool BuzzQueue::isEmpty() const {
+  return count == 0;
+}
+
+bool BuzzQueue::isFull() const {
+  return count == MAX_CLIENTS;
+}
+
+uint8_t BuzzQueue::at(uint8_t position) const {
+  return entries[slotOf(position)];
+}
+
+int8_t BuzzQueue::find(uint8_t client) const {
+  if (!hasBuzzed(client)) return -1;
+  for (uint8_t position = 0; position < count; position++) {
+    if (at(position) == client) {
+      return position;
+    }
+  }
+  return -1;
+}
+
+bool BuzzQueue::push(uint8_t client) {
+  if (isFull()) return false;
+  entries[slotOf(count)] = client;
+  count++;
+  return true;
+}
+
+bool BuzzQueue::insert(uint8_t position, uint8_t client) {
+  if (isFull() || position > count) return false;
+  for (uint8_t i = count; i > position; i--) {
+    entries[slotOf(i)] = entries[slotOf(i - 1)];
+  }
+  entries[slotOf(position)] = client;
+  count++;
+  return true;
+}
+
+uint8_t BuzzQueue::popFront() {
+  if (isEmpty()) return UINT8_MAX;
+  uint8_t client = entries[head];
+  head = slotOf(1);
+  count--;
+  return client;
+}
+
+bool BuzzQueue::remove(uint8_t position) {
+  if (position >= count) return false;
+  if (position == 0) {
+    popFront();
+    return true;
+  }
+  for (uint8_t i = position; i + 1 < count; i++) {
+    entries[slotOf(i)] = entries[slotOf(i + 1)];
+  }
+  count--;
+  return true;
+}
+
+void BuzzQueue::markBuzzed(uint8_t client) {
+  buzzedMask |= (uint16_t)1 << client;
+}
+
+void BuzzQueue::clearBuzzed(uint8_t client) {
+  buzzedMask &= ~((uint16_t)1 << client);
+}
+
+bool BuzzQueue::hasBuzzed(uint8_t client) const {
+  return client < MAX_CLIENTS && (buzzedMask & ((uint16_t)1 << client));
+}
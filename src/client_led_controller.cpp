@@ -49,83 +49,79 @@ void ClientLEDController::showSolidColor(const Rgb& color) {
   setAllLEDs(color);
 }
 
-void ClientLEDController::animateIdle(const Rgb& color) {
-  // Soft pulse in assigned color
-  static uint32_t lastUpdate = 0;
-  if (millis() - lastUpdate > PULSE_SPEED_MS) {
-    float breath = (sin(millis() * 0.003) + 1.0) * 0.5; // 0.0 to 1.0
-    uint8_t brightness = (uint8_t)(breath * 255);
-    
-    Rgb pulseColor(
-      (uint8_t)(color.r * brightness / 255),
-      (uint8_t)(color.g * brightness / 255),
-      (uint8_t)(color.b * brightness / 255)
-    );
-    
-    setAllLEDs(pulseColor);
-    lastUpdate = millis();
-  }
+void ClientLEDController::animateIdle(const Rgb& color, uint32_t hubTime) {
+  // Soft pulse in assigned color - phase from hub time, same as server pulse
+  float breath = (sin(hubTime * 0.003) + 1.0) * 0.5; // 0.0 to 1.0
+  uint8_t brightness = (uint8_t)(breath * 255);
+  
+  Rgb pulseColor(
+    (uint8_t)(color.r * brightness / 255),
+    (uint8_t)(color.g * brightness / 255),
+    (uint8_t)(color.b * brightness / 255)
+  );
+  
+  setAllLEDs(pulseColor);
 }
 
 void ClientLEDController::animateActiveSpin(const Rgb& color) {
   // Fast spinning animation
-  static uint32_t lastUpdate = 0;
   static uint16_t animStep = 0;
   
-  if (millis() - lastUpdate > SPIN_SPEED_MS) {
-    clearAllLEDs();
-    
-    // Light up current position
-    uint16_t position = animStep % LED_COUNT;
-    setPixelColor(position, color);
-    
-    // Add trailing LEDs for better effect
-    for (uint8_t i = 1; i <= 2 && i <= position; i++) {
-      Rgb trailColor(
-        (uint8_t)(color.r / (i + 1)),
-        (uint8_t)(color.g / (i + 1)),
-        (uint8_t)(color.b / (i + 1))
-      );
-      setPixelColor(position - i, trailColor);
-    }
-    
-    strip.show();
-    animStep++;
-    lastUpdate = millis();
+  clearAllLEDs();
+  
+  // Light up current position
+  uint16_t position = animStep % LED_COUNT;
+  setPixelColor(position, color);
+  
+  // Add trailing LEDs for better effect
+  for (uint8_t i = 1; i <= 2 && i <= position; i++) {
+    Rgb trailColor(
+      (uint8_t)(color.r / (i + 1)),
+      (uint8_t)(color.g / (i + 1)),
+      (uint8_t)(color.b / (i + 1))
+    );
+    setPixelColor(position - i, trailColor);
   }
+  
+  strip.show();
+  animStep++;
 }
 
-void ClientLEDController::animateFlash(const Rgb& color) {
-  // Quick flash animation
-  static uint32_t flashStart = 0;
-  static bool flashActive = false;
+void ClientLEDController::animateFlash(const Rgb& color, uint32_t elapsed) {
+  // Quick flash animation, elapsed since the shared start instant
+  static int8_t lastOn = -1;
+  static uint32_t lastElapsed = 0;
   
-  if (!flashActive) {
-    flashStart = millis();
-    flashActive = true;
+  if (elapsed < lastElapsed) {
+    lastOn = -1; // new flash started
   }
-  
-  uint32_t elapsed = millis() - flashStart;
+  lastElapsed = elapsed;
   
   if (elapsed < FLASH_DURATION_MS * 4) { // 4 flashes
-    if ((elapsed / FLASH_DURATION_MS) % 2 == 0) {
-      setAllLEDs(color);
-    } else {
-      clearAllLEDs();
+    int8_t on = ((elapsed / FLASH_DURATION_MS) % 2 == 0) ? 1 : 0;
+    if (on != lastOn) {
+      if (on) {
+        setAllLEDs(color);
+      } else {
+        clearAllLEDs();
+      }
+      lastOn = on;
     }
-  } else {
+  } else if (lastOn != -1) {
     // Flash finished
-    flashActive = false;
+    lastOn = -1;
     clearAllLEDs();
   }
 }
 
-void ClientLEDController::animateCelebration() {
-  // Rainbow animation
-  static uint32_t lastUpdate = 0;
-  static uint16_t animStep = 0;
+void ClientLEDController::animateCelebration(uint32_t elapsed) {
+  // Rainbow animation - frame from elapsed time, so it runs frame-locked
+  // with the server strip and the other buzzers
+  static uint32_t lastFrame = UINT32_MAX;
+  uint32_t frame = elapsed / CELEBRATION_FRAME_MS;
   
-  if (millis() - lastUpdate > 50) {
+  if (frame != lastFrame) {
+    uint16_t animStep = frame * 5;
     for (uint16_t i = 0; i < LED_COUNT; i++) {
       uint8_t hue = (animStep + i * (256 / LED_COUNT)) & 255;
       
@@ -149,20 +145,14 @@ void ClientLEDController::animateCelebration() {
       setPixelColor(i, rainbowColor);
     }
     strip.show();
-    animStep += 5;
-    lastUpdate = millis();
+    lastFrame = frame;
   }
 }
 
 void ClientLEDController::animateDisconnected() {
-  // Slow red pulse to indicate no connection
-  static uint32_t lastUpdate = 0;
-  if (millis() - lastUpdate > 200) {
-    static bool redState = false;
-    setAllLEDs(redState ? COLOR_ERROR : COLOR_BLACK);
-    redState = !redState;
-    lastUpdate = millis();
-  }
+  // Slow red pulse to indicate no connection - 200ms on, 200ms off
+  bool redState = (millis() / 200) % 2 == 0;
+  setAllLEDs(redState ? COLOR_ERROR : COLOR_BLACK);
 }
 
 void ClientLEDController::showLocked(const Rgb& color) {
@@ -2,16 +2,20 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <Adafruit_NeoPixel.h>
-#include <Bounce2.h>
+#include <esp_timer.h>
 #include "config.h"
 #include "protocol.h"
 #include "client_led_controller.h"
 #include "client_mqtt.h"
 #include "client_manager.h"
+#include "event_loop.h"
 
 // Hardware Objects
 Adafruit_NeoPixel strip(LED_COUNT, LED_PIN, NEO_GRB + NEO_KHZ800);
-Bounce button = Bounce();
+
+static void pingServer() {
+  if (clientMqtt) clientMqtt->sendPing();
+}
 
 void setup() {
   Serial.begin(115200);
@@ -19,6 +23,9 @@ void setup() {
   Serial.printf("Hardware Config - LED Pin: %d, Button Pin: %d, LED Count: %d\n", 
                 LED_PIN, BUTTON_PIN, LED_COUNT);
   
+  // Loop task sleeps between events from here on
+  eventLoop.begin();
+  
   // Initialize LEDs
   strip.begin();
   strip.setBrightness(LED_BRIGHTNESS);
@@ -28,19 +35,17 @@ void setup() {
   // Initialize LED Controller
   clientLedController = new ClientLEDController(strip);
   
-  // Initialize Button
-  pinMode(BUTTON_PIN, INPUT_PULLUP);
-  button.attach(BUTTON_PIN);
-  button.interval(DEBOUNCE_MS);
-  
   // Initialize Button Handler
-  clientButtonHandler = new ClientButtonHandler(button);
+  clientButtonHandler = new ClientButtonHandler();
+  clientButtonHandler->begin();
   
   // Initialize MQTT Client
   clientMqtt = new ClientMQTT();
   
   // Initialize Client Manager
   clientManager = new ClientManager();
+  clientManager->begin();
+  eventLoop.addTimer("ping", CLIENT_PING_INTERVAL_MS, pingServer);
   
   // RGB LED test sequence
   Serial.println("Starting RGB LED test...");
@@ -66,7 +71,9 @@ void loop() {
         // Connected - handle normal states
         if (clientManager->getState() == ClientState::DISCONNECTED) {
           if (clientManager->isAssigned()) {
-            clientManager->setState(ClientState::IDLE);
+            // Buzzed while offline - stay locked until the server answers
+            clientManager->setState(clientManager->getData().hasBuzzed ? 
+                                    ClientState::LOCKED_AFTER_BUZZ : ClientState::IDLE);
           } else {
             clientManager->setState(ClientState::CONNECTING);
           }
@@ -85,11 +92,12 @@ void loop() {
     clientButtonHandler->update();
     
     if (clientButtonHandler->wasPressed()) {
-      Serial.println("Button pressed!");
+      Serial.printf("Button pressed! (edge %d us ago)\n",
+                    (int32_t)(esp_timer_get_time() - clientButtonHandler->getPressTimeUs()));
       
       if (clientManager) {
         if (clientManager->canBuzz()) {
-          clientManager->buzz();
+          clientManager->buzz(clientButtonHandler->getPressTimeUs());
         } else {
           Serial.println("Cannot buzz right now");
           
@@ -109,5 +117,17 @@ void loop() {
     clientManager->handleStateAnimations();
   }
   
-  delay(10); // Small delay for stability
+  // LED frames and ping
+  eventLoop.run();
+  
+  // Sleep until the button, the next timer or deadline, or the next network poll
+  uint32_t limit = UINT32_MAX;
+  if (clientMqtt) {
+    eventLoop.setPollInterval(clientMqtt->isLive() ? EVENT_POLL_ACTIVE_MS : EVENT_POLL_IDLE_MS);
+    limit = clientMqtt->msUntilDue();
+  }
+  if (clientManager && clientManager->msUntilScheduled() < limit) {
+    limit = clientManager->msUntilScheduled();
+  }
+  eventLoop.wait(limit);
 }
\ No newline at end of file
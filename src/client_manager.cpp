@@ -1,11 +1,29 @@
 #include "client_manager.h"
 #include "client_led_controller.h"
 #include "client_mqtt.h"
+#include "event_loop.h"
+#include <esp_timer.h>
 
 // Global instances
 ClientManager* clientManager = nullptr;
 ClientButtonHandler* clientButtonHandler = nullptr;
 
+static void renderStateFrame() {
+  if (clientManager) clientManager->renderState();
+}
+
+// LED frame period per state - each animation draws one step per frame
+static uint16_t framePeriodFor(ClientState state) {
+  switch (state) {
+    case ClientState::DISCONNECTED: return 50;
+    case ClientState::IDLE: return PULSE_SPEED_MS;
+    case ClientState::ACTIVE_TURN: return SPIN_SPEED_MS;
+    case ClientState::CELEBRATE: return CELEBRATION_FRAME_MS;
+    case ClientState::WRONG_FLASH: return 20;
+    default: return 100;
+  }
+}
+
 // ClientManager Implementation
 ClientManager::ClientManager() {
   // Initialize with defaults
@@ -14,17 +32,44 @@ ClientManager::ClientManager() {
   data.assignedColor = Rgb(255, 0, 0); // Default red
   data.hasBuzzed = false;
   data.isActive = false;
+  data.stateSince = millis();
+  scheduledState = ClientState::IDLE;
+  scheduledAt = 0;
+  hasScheduledState = false;
+  frameState = data.currentState;
+  frameTimer = EventLoop::NO_TIMER;
   
   if (clientMqtt) {
     data.id = clientMqtt->getClientId();
   }
 }
 
+void ClientManager::begin() {
+  frameTimer = eventLoop.addTimer("leds", framePeriodFor(data.currentState), renderStateFrame);
+}
+
 void ClientManager::setState(ClientState newState) {
+  if (data.currentState != newState) {
+    setState(newState, millis());
+  }
+}
+
+void ClientManager::setState(ClientState newState, uint32_t since) {
   if (data.currentState != newState) {
     Serial.printf("State change: %d -> %d\n", (int)data.currentState, (int)newState);
     data.currentState = newState;
   }
+  data.stateSince = since; // Restarts the effect even if the state is unchanged
+}
+
+void ClientManager::scheduleState(ClientState newState, uint32_t localStart) {
+  scheduledState = newState;
+  scheduledAt = localStart;
+  hasScheduledState = true;
+}
+
+void ClientManager::cancelScheduledState() {
+  hasScheduledState = false;
 }
 
 ClientState ClientManager::getState() const {
@@ -32,11 +77,36 @@ ClientState ClientManager::getState() const {
 }
 
 void ClientManager::handleStateAnimations() {
+  // Scheduled effect reached its start instant
+  if (hasScheduledState && (int32_t)(millis() - scheduledAt) >= 0) {
+    hasScheduledState = false;
+    setState(scheduledState, scheduledAt);
+  }
+  
+  // State changes restart the LED frame timer at the new state's rate, so the
+  // first frame of the new state is drawn right away
+  if (data.currentState != frameState) {
+    frameState = data.currentState;
+    eventLoop.setPeriod(frameTimer, framePeriodFor(frameState));
+  }
+}
+
+uint32_t ClientManager::msUntilScheduled() const {
+  if (!hasScheduledState) return UINT32_MAX;
+  int32_t remaining = (int32_t)(scheduledAt - millis());
+  return remaining > 0 ? remaining : 0;
+}
+
+void ClientManager::renderState() {
   if (!clientLedController) return;
   
   // Check if game is OPEN for different idle behavior
   extern bool gameIsOpen; // We'll need to track this
   
+  // Effects render from time since their start, not from when this board
+  // happened to process the command
+  uint32_t elapsed = millis() - data.stateSince;
+  
   switch (data.currentState) {
     case ClientState::DISCONNECTED:
       clientLedController->animateDisconnected();
@@ -46,10 +116,8 @@ void ClientManager::handleStateAnimations() {
       // Show assigned color briefly, then go to idle
       clientLedController->setAllLEDs(data.assignedColor);
       // Auto-transition after showing assignment
-      static uint32_t assignmentStart = millis();
-      if (millis() - assignmentStart > 2000) {
+      if (elapsed > 2000) {
         setState(ClientState::IDLE);
-        assignmentStart = millis() + 60000; // Don't repeat for a while
       }
       break;
       
@@ -57,7 +125,9 @@ void ClientManager::handleStateAnimations() {
       if (isAssigned()) {
         // Different behavior based on game state
         if (gameIsOpen) {
-          clientLedController->animateIdle(data.assignedColor); // Pulse when ready to buzz
+          // Pulse when ready to buzz, phased on hub time like the server strip
+          uint32_t hubNow = clientMqtt ? clientMqtt->localToHub(millis()) : millis();
+          clientLedController->animateIdle(data.assignedColor, hubNow);
         } else {
           clientLedController->showSolidColor(data.assignedColor); // Solid when waiting
         }
@@ -81,30 +151,20 @@ void ClientManager::handleStateAnimations() {
       break;
       
     case ClientState::CELEBRATE:
-      clientLedController->animateCelebration();
+      clientLedController->animateCelebration(elapsed);
       // Auto-return to idle after celebration
-      static uint32_t celebrationStart = 0;
-      if (celebrationStart == 0) {
-        celebrationStart = millis();
-      }
-      if (millis() - celebrationStart > CELEBRATION_DURATION_MS) {
+      if (elapsed > CELEBRATION_DURATION_MS) {
         setState(ClientState::IDLE);
-        celebrationStart = 0; // Reset for next time
       }
       break;
       
     case ClientState::WRONG_FLASH:
-      clientLedController->animateFlash(COLOR_ERROR);
+      clientLedController->animateFlash(COLOR_ERROR, elapsed);
       // Auto-return to idle after flash
-      static uint32_t flashStart = 0;
-      if (flashStart == 0) {
-        flashStart = millis();
-      }
-      if (millis() - flashStart > FLASH_DURATION_MS * 4) {
+      if (elapsed > FLASH_DURATION_MS * 4) {
         // Reset buzz state so client can buzz again
         resetBuzzState();
         setState(ClientState::IDLE);
-        flashStart = 0; // Reset for next time
         Serial.println("WRONG_FLASH complete - can buzz again");
       }
       break;
@@ -124,30 +184,54 @@ void ClientManager::setAssignment(uint8_t slot, const Rgb& color) {
                 slot, color.r, color.g, color.b);
 }
 
+// Assignment and our standing in the current question applied together -
+// no assignment flash, straight into the state the server has for us
+void ClientManager::restore(uint8_t slot, const Rgb& color, bool queued, bool active) {
+  // A buzz the server hasn't answered yet isn't in the snapshot - stay
+  // locked until its ack says where we stand
+  if (clientMqtt && clientMqtt->hasBuzzInFlight()) {
+    queued = true;
+  }
+  
+  data.slot = slot;
+  data.assignedColor = color;
+  data.hasBuzzed = queued;
+  data.isActive = active;
+  cancelScheduledState();
+  setState(active ? ClientState::ACTIVE_TURN : queued ? ClientState::LOCKED_AFTER_BUZZ : ClientState::IDLE);
+  
+  Serial.printf("Restored slot %d (queued: %s, active: %s)\n", slot, queued ? "yes" : "no", active ? "yes" : "no");
+}
+
 bool ClientManager::isAssigned() const {
   return data.slot > 0;
 }
 
-void ClientManager::buzz() {
+void ClientManager::buzz(int64_t pressTimeUs) {
   if (!canBuzz()) return;
   
   data.hasBuzzed = true;
   setState(ClientState::LOCKED_AFTER_BUZZ);
   
-  // Send buzz via MQTT
-  if (clientMqtt && clientMqtt->isConnected()) {
-    clientMqtt->sendBuzz();
+  // Send buzz via MQTT (buffered for reconnect while offline)
+  if (clientMqtt) {
+    clientMqtt->sendBuzz(pressTimeUs);
   }
   
   Serial.println("BUZZED!");
 }
 
 bool ClientManager::canBuzz() const {
-  return isAssigned() && 
-         !data.hasBuzzed && 
-         data.currentState == ClientState::IDLE &&
-         clientMqtt && 
-         clientMqtt->isConnected();
+  if (!isAssigned() || data.hasBuzzed || !clientMqtt) {
+    return false;
+  }
+  
+  if (clientMqtt->isConnected()) {
+    return data.currentState == ClientState::IDLE;
+  }
+  
+  // Brief Wi-Fi drop during an open question - the press gets buffered
+  return data.currentState == ClientState::DISCONNECTED && clientMqtt->canBufferBuzz();
 }
 
 void ClientManager::resetBuzzState() {
@@ -155,6 +239,20 @@ void ClientManager::resetBuzzState() {
   data.isActive = false;
 }
 
+void ClientManager::confirmBuzz() {
+  data.hasBuzzed = true;
+  if (data.currentState != ClientState::ACTIVE_TURN) {
+    setState(ClientState::LOCKED_AFTER_BUZZ);
+  }
+}
+
+void ClientManager::releaseBuzz() {
+  resetBuzzState();
+  if (data.currentState == ClientState::LOCKED_AFTER_BUZZ) {
+    setState(ClientState::IDLE);
+  }
+}
+
 const ClientManager::ClientData& ClientManager::getData() const {
   return data;
 }
@@ -168,22 +266,32 @@ const Rgb& ClientManager::getAssignedColor() const {
 }
 
 // ClientButtonHandler Implementation
-ClientButtonHandler::ClientButtonHandler(Bounce& btn) : button(btn), lastButtonPress(0), buttonPressed(false) {
+ClientButtonHandler::ClientButtonHandler(DebounceMode debounceMode) : debouncer(debounceMode) {
+}
+
+void IRAM_ATTR ClientButtonHandler::onButtonEdge(void* arg) {
+  ClientButtonHandler* handler = static_cast<ClientButtonHandler*>(arg);
+  handler->debouncer.captureEdge(digitalRead(BUTTON_PIN) == LOW, esp_timer_get_time());
+  eventLoop.wakeFromISR();
+}
+
+void ClientButtonHandler::begin() {
+  pinMode(BUTTON_PIN, INPUT_PULLUP);
+  attachInterruptArg(digitalPinToInterrupt(BUTTON_PIN), onButtonEdge, this, FALLING);
 }
 
 void ClientButtonHandler::update() {
-  button.update();
-  
-  if (button.fell() && !buttonPressed) {
-    buttonPressed = true;
-    lastButtonPress = millis();
-  }
+  debouncer.update(digitalRead(BUTTON_PIN) == LOW, esp_timer_get_time());
 }
 
 bool ClientButtonHandler::wasPressed() {
-  if (buttonPressed) {
-    buttonPressed = false; // Reset flag
-    return true;
-  }
-  return false;
+  return debouncer.wasPressed();
+}
+
+uint32_t ClientButtonHandler::getPressTime() const {
+  return (uint32_t)(debouncer.getPressTimeUs() / 1000); // millis() is esp_timer / 1000
+}
+
+int64_t ClientButtonHandler::getPressTimeUs() const {
+  return debouncer.getPressTimeUs();
 }
@@ -1,12 +1,98 @@
 #include "client_mqtt.h"
 #include "client_manager.h"
 #include "client_led_controller.h"
+#include "heap_counter.h"
+#include "event_loop.h"
+#include <esp_timer.h>
+#include <esp_system.h>
 
 // Global instance
 ClientMQTT* clientMqtt = nullptr;
 bool gameIsOpen = false; // Track if game is in OPEN state
 
-ClientMQTT::ClientMQTT() : mqttClient(wifiClient), connected(false), lastConnectionAttempt(0), lastPing(0) {
+// Press made during a Wi-Fi drop, kept in RTC memory so it also survives
+// a brownout reset - valid while magic is set
+constexpr uint32_t OFFLINE_BUZZ_MAGIC = 0xB022B0FF;
+struct OfflineBuzz {
+  uint32_t magic;
+  uint16_t seq;
+  uint32_t hubTime;   // press time converted to hub clock
+};
+RTC_NOINIT_ATTR static OfflineBuzz offlineBuzz;
+
+// Last state and queue seen from the server. Both share one sequence per
+// server epoch: a state older than the last state is stale, a queue older
+// than the last state or queue too (the state may have emptied it).
+struct StateView {
+  bool epochKnown;
+  uint16_t epoch;
+  bool stateKnown;
+  uint16_t stateSeq;
+  bool queueKnown;
+  uint16_t queueSeq;
+  bool queueValid;            // queue mirrors the server's as of queueSeq
+  Wire::QueueMessage queue;
+};
+static StateView view = {};
+
+static inline bool sequenceAfter(uint16_t seq, uint16_t last) {
+  return (int16_t)(seq - last) > 0;
+}
+
+// New epoch = server rebooted, its sequence started over
+static void enterEpoch(uint16_t epoch) {
+  if (!view.epochKnown || view.epoch != epoch) {
+    view.epochKnown = true;
+    view.epoch = epoch;
+    view.stateKnown = false;
+    view.queueKnown = false;
+    view.queueValid = false;
+  }
+}
+
+static bool acceptStateSequence(uint16_t epoch, uint16_t seq) {
+  enterEpoch(epoch);
+  if (view.stateKnown && !sequenceAfter(seq, view.stateSeq)) return false;
+  view.stateKnown = true;
+  view.stateSeq = seq;
+  return true;
+}
+
+static bool acceptQueueSequence(uint16_t epoch, uint16_t seq) {
+  enterEpoch(epoch);
+  if (view.stateKnown && !sequenceAfter(seq, view.stateSeq)) return false;
+  if (view.queueKnown && !sequenceAfter(seq, view.queueSeq)) return false;
+  view.queueKnown = true;
+  view.queueSeq = seq;
+  return true;
+}
+
+// Inbound dispatch, indexed by TopicId - filled in begin()
+static MessageHandler clientHandlers[TOPIC_COUNT + 1];
+
+// Exponential backoff with equal jitter - half the delay fixed, half random,
+// so buzzers that lost the AP together don't retry (and join) in lockstep
+static uint32_t backoffDelay(uint8_t attempts) {
+  uint32_t delayMs = RECONNECT_BACKOFF_MIN_MS;
+  for (uint8_t i = 0; i < attempts && delayMs < RECONNECT_BACKOFF_MAX_MS; i++) {
+    delayMs *= 2;
+  }
+  if (delayMs > RECONNECT_BACKOFF_MAX_MS) {
+    delayMs = RECONNECT_BACKOFF_MAX_MS;
+  }
+  return delayMs / 2 + esp_random() % (delayMs / 2 + 1);
+}
+
+ClientMQTT::ClientMQTT() : mqttClient(wifiClient), connected(false),
+                           linkState(LinkState::WIFI_BACKOFF), linkSince(0), retryAt(0),
+                           wifiAttempts(0), mqttAttempts(0),
+                           codec(Wire::Codec::JSON),
+                           buzzFrameLength(0), buzzFrameSeqOffset(0), buzzFrameTimeOffset(0), buzzFrameReady(false),
+                           buzzFrameCodec(Wire::Codec::JSON),
+                           lastBuzzPressTime(0), lastBuzzSendTime(0),
+                           buzzSeq(0), buzzRetries(0), buzzPending(false), buzzIsOffline(false),
+                           buzzFalseStart(false), lastConnectedTime(0), joinAnswered(false), openScheduled(false), openLocalTime(0),
+                           receivedMessages(0), receiveAllocations(0) {
   // Generate unique client ID based on MAC
   uint64_t mac = ESP.getEfuseMac();
   clientId = "C-" + String((uint32_t)(mac >> 16), HEX);
@@ -15,67 +101,151 @@ ClientMQTT::ClientMQTT() : mqttClient(wifiClient), connected(false), lastConnect
 void ClientMQTT::begin() {
   Serial.printf("Client ID: %s\n", clientId.c_str());
   
+  // RTC memory holds garbage after power-on, only resets keep the buffered buzz
+  if (esp_reset_reason() == ESP_RST_POWERON) {
+    offlineBuzz.magic = 0;
+  }
+  
+  // Receive path runs in this task - count its heap allocations (HEAP_COUNTER builds)
+  HeapCounter::watchCurrentTask();
+  
+  clientHandlers[(uint8_t)TopicId::ASSIGN] = handleAssignment;
+  clientHandlers[(uint8_t)TopicId::STATE] = handleGameState;
+  clientHandlers[(uint8_t)TopicId::QUEUE] = handleQueue;
+  clientHandlers[(uint8_t)TopicId::CMD] = handleCommand;
+  clientHandlers[(uint8_t)TopicId::ACK] = handleBuzzAck;
+  clientHandlers[(uint8_t)TopicId::SYNC] = handleClockSync;
+  
   // Set MQTT server and callback
   mqttClient.setServer(MQTT_HOST, MQTT_PORT);
+  mqttClient.setSocketTimeout(MQTT_CONNACK_TIMEOUT_S);
   mqttClient.setCallback([this](char* topic, byte* payload, unsigned int length) {
     this->onMessage(topic, payload, length);
   });
   
-  // Try initial connection
-  connectWiFi();
+  // Reconnects follow our backoff, not the driver's
+  WiFi.setAutoReconnect(false);
+  
+  // Start initial connection - loop() takes it from here
+  startWiFi();
 }
 
 void ClientMQTT::loop() {
-  // Handle MQTT connection
-  if (WiFi.status() == WL_CONNECTED) {
-    if (!mqttClient.connected()) {
-      // Try to reconnect every 5 seconds
-      if (millis() - lastConnectionAttempt > 5000) {
-        connectMQTT();
-        lastConnectionAttempt = millis();
+  // Unlock at the announced instant, connected or not
+  updateOpenSchedule();
+  
+  // Handle Wi-Fi/MQTT connection
+  updateLink();
+  if (linkState == LinkState::CONNECTED) {
+    mqttClient.loop();
+    retransmitBuzz();
+    lastConnectedTime = millis();
+  }
+}
+
+void ClientMQTT::setLinkState(LinkState state) {
+  linkState = state;
+  linkSince = millis();
+}
+
+void ClientMQTT::enterBackoff(LinkState state, uint8_t& attempts) {
+  uint32_t delayMs = backoffDelay(attempts);
+  if (attempts < UINT8_MAX) {
+    attempts++;
+  }
+  retryAt = millis() + delayMs;
+  setLinkState(state);
+  Serial.printf("%s retry in %u ms\n", state == LinkState::WIFI_BACKOFF ? "WiFi" : "MQTT", delayMs);
+}
+
+// One step per loop - every wait is a state with a deadline
+void ClientMQTT::updateLink() {
+  uint32_t now = millis();
+  bool wifiUp = WiFi.status() == WL_CONNECTED;
+  
+  switch (linkState) {
+    case LinkState::WIFI_CONNECTING:
+      if (wifiUp) {
+        Serial.printf("WiFi connected! IP: %s\n", WiFi.localIP().toString().c_str());
+        wifiAttempts = 0;
+        // First broker attempt jittered too - every buzzer sees the AP come back at once
+        enterBackoff(LinkState::MQTT_BACKOFF, mqttAttempts);
+      } else if (now - linkSince >= WIFI_CONNECT_TIMEOUT_MS) {
+        Serial.println("WiFi connection failed!");
+        WiFi.disconnect();
+        enterBackoff(LinkState::WIFI_BACKOFF, wifiAttempts);
       }
-    } else {
-      mqttClient.loop();
+      break;
       
-      // Send ping every 10 seconds
-      if (millis() - lastPing > 10000) {
-        sendPing();
-        lastPing = millis();
+    case LinkState::WIFI_BACKOFF:
+      if ((int32_t)(now - retryAt) >= 0) {
+        startWiFi();
       }
-    }
-  } else {
-    // WiFi disconnected, try to reconnect
-    if (millis() - lastConnectionAttempt > 10000) {
-      connectWiFi();
-      lastConnectionAttempt = millis();
-    }
+      break;
+      
+    case LinkState::MQTT_BACKOFF:
+      if (!wifiUp) {
+        Serial.println("WiFi lost");
+        WiFi.disconnect();
+        enterBackoff(LinkState::WIFI_BACKOFF, wifiAttempts);
+      } else if ((int32_t)(now - retryAt) >= 0) {
+        if (connectMQTT()) {
+          mqttAttempts = 0;
+          setLinkState(LinkState::CONNECTED);
+        } else {
+          enterBackoff(LinkState::MQTT_BACKOFF, mqttAttempts);
+        }
+      }
+      break;
+      
+    case LinkState::CONNECTED:
+      if (!wifiUp) {
+        Serial.println("WiFi lost");
+        wifiClient.stop();
+        WiFi.disconnect();
+        enterBackoff(LinkState::WIFI_BACKOFF, wifiAttempts);
+      } else if (!mqttClient.connected()) {
+        Serial.printf("MQTT connection lost, rc=%d\n", mqttClient.state());
+        enterBackoff(LinkState::MQTT_BACKOFF, mqttAttempts);
+      }
+      break;
+  }
+}
+
+// Poll the socket tightly only while a question is live or a buzz awaits its ack
+bool ClientMQTT::isLive() const {
+  return gameIsOpen || openScheduled || buzzPending;
+}
+
+// Until the open instant or the next buzz retransmit, UINT32_MAX if neither
+uint32_t ClientMQTT::msUntilDue() const {
+  uint32_t now = millis();
+  int32_t next = INT32_MAX;
+  if (openScheduled && !gameIsOpen) {
+    next = (int32_t)(openLocalTime - now);
+  }
+  if (buzzPending) {
+    int32_t retry = (int32_t)(lastBuzzSendTime + BUZZ_RETRY_MS - now);
+    if (retry < next) next = retry;
+  }
+  if (linkState == LinkState::WIFI_BACKOFF || linkState == LinkState::MQTT_BACKOFF) {
+    int32_t reconnect = (int32_t)(retryAt - now);
+    if (reconnect < next) next = reconnect;
   }
+  if (next == INT32_MAX) return UINT32_MAX;
+  return next > 0 ? next : 0;
 }
 
 bool ClientMQTT::isConnected() {
-  return WiFi.status() == WL_CONNECTED && mqttClient.connected();
+  return linkState == LinkState::CONNECTED && WiFi.status() == WL_CONNECTED && mqttClient.connected();
 }
 
-bool ClientMQTT::connectWiFi() {
+void ClientMQTT::startWiFi() {
   Serial.printf("Connecting to WiFi: %s\n", WIFI_SSID);
   
   WiFi.mode(WIFI_STA);
   WiFi.begin(WIFI_SSID, WIFI_PSK);
-  
-  // Wait up to 10 seconds for connection
-  uint32_t startTime = millis();
-  while (WiFi.status() != WL_CONNECTED && millis() - startTime < 10000) {
-    delay(100);
-    Serial.print(".");
-  }
-  
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.printf("\nWiFi connected! IP: %s\n", WiFi.localIP().toString().c_str());
-    return true;
-  } else {
-    Serial.println("\nWiFi connection failed!");
-    return false;
-  }
+  setLinkState(LinkState::WIFI_CONNECTING);
 }
 
 void ClientMQTT::disconnectWiFi() {
@@ -85,22 +255,45 @@ void ClientMQTT::disconnectWiFi() {
 bool ClientMQTT::connectMQTT() {
   Serial.printf("Connecting to MQTT broker: %s:%d\n", MQTT_HOST, MQTT_PORT);
   
+  // TCP connect with a short timeout of our own - PubSubClient's would block
+  // for seconds while the broker is still booting. Given an open socket it
+  // only sends CONNECT and waits up to MQTT_CONNACK_TIMEOUT_S.
+  if (!wifiClient.connected() && !wifiClient.connect(MQTT_HOST, MQTT_PORT, MQTT_CONNECT_TIMEOUT_MS)) {
+    Serial.println("MQTT broker unreachable");
+    return false;
+  }
+  
   if (mqttClient.connect(clientId.c_str())) {
     Serial.println("MQTT connected!");
     
+    // Disable Nagle - a buzz must leave in its own segment right away
+    wifiClient.setNoDelay(true);
+    
+    // JSON until the server answers our join with a binary assignment
+    setCodec(Wire::Codec::JSON);
+    
     // Subscribe to topics
     String assignTopic = String(Topic::ASSIGN) + clientId;
     mqttClient.subscribe(assignTopic.c_str());
+    String ackTopic = String(Topic::ACK) + clientId;
+    mqttClient.subscribe(ackTopic.c_str());
+    String syncTopic = String(Topic::SYNC) + clientId;
+    mqttClient.subscribe(syncTopic.c_str());
     mqttClient.subscribe(Topic::STATE);
     mqttClient.subscribe(Topic::QUEUE);
     mqttClient.subscribe(Topic::CMD);
+    String cmdTopic = String(Topic::CLIENT_CMD) + clientId;
+    mqttClient.subscribe(cmdTopic.c_str());
     
-    // Send join request
+    // Send join request - a press made while offline follows once it is
+    // answered, so the snapshot can't overtake the buzz and unlock us
+    joinAnswered = false;
     sendJoinRequest();
     
     return true;
   } else {
     Serial.printf("MQTT connection failed, rc=%d\n", mqttClient.state());
+    wifiClient.stop();
     return false;
   }
 }
@@ -109,65 +302,377 @@ void ClientMQTT::disconnectMQTT() {
   mqttClient.disconnect();
 }
 
+// Receive path - payload is decoded straight from PubSubClient's buffer into
+// stack structs, nothing here touches the heap
 void ClientMQTT::onMessage(char* topic, byte* payload, unsigned int length) {
-  // Convert payload to string
-  String payloadStr = "";
-  for (unsigned int i = 0; i < length; i++) {
-    payloadStr += (char)payload[i];
+  uint32_t allocationsBefore = HeapCounter::count();
+  
+  // Print in pieces - printf falls back to malloc for long lines
+  Serial.print("MQTT received - Topic: ");
+  Serial.print(topic);
+  if (Wire::isBinary(payload, length)) {
+    Serial.print(", binary bytes: ");
+    Serial.println(length);
+  } else {
+    Serial.print(", Payload: ");
+    Serial.write(payload, length);
+    Serial.println();
   }
   
-  String topicStr = String(topic);
-  Serial.printf("MQTT received - Topic: %s, Payload: %s\n", topicStr.c_str(), payloadStr.c_str());
-  
-  // Handle different message types
-  if (topicStr.startsWith(Topic::ASSIGN)) {
-    handleAssignment(payloadStr);
-  } else if (topicStr == Topic::STATE) {
-    handleGameState(payloadStr);
-  } else if (topicStr == Topic::QUEUE) {
-    handleQueue(payloadStr);
-  } else if (topicStr == Topic::CMD) {
-    handleCommand(payloadStr);
+  // One hash lookup picks the handler
+  MessageHandler handler = clientHandlers[(uint8_t)topicToId(topic)];
+  if (handler && Wire::isBatch(payload, length)) {
+    // Several messages for this topic in one publish
+    size_t offset = 0;
+    const uint8_t* frame;
+    size_t frameLength;
+    while (Wire::nextBatchFrame(payload, length, offset, frame, frameLength)) {
+      handler(frame, frameLength);
+    }
+  } else if (handler) {
+    handler(payload, length);
   }
+  
+  receivedMessages++;
+  receiveAllocations += HeapCounter::count() - allocationsBefore;
+}
+
+void ClientMQTT::resetReceiveStats() {
+  receivedMessages = 0;
+  receiveAllocations = 0;
+}
+
+void ClientMQTT::logReceiveStats() {
+  if (!HeapCounter::isEnabled()) return;
+  Serial.printf("Receive path: %u msgs, %u heap allocs\n", receivedMessages, receiveAllocations);
 }
 
 void ClientMQTT::sendJoinRequest() {
-  StaticJsonDocument<200> doc;
-  doc[JsonKey::ID] = clientId;
-  doc[JsonKey::CAPABILITY] = LED_COUNT;
-  doc[JsonKey::FIRMWARE] = "1.0";
+  // Firmware version tells the server we also speak the binary codec
+  Wire::JoinMessage msg;
+  strlcpy(msg.id, clientId.c_str(), sizeof(msg.id));
+  msg.capability = LED_COUNT;
+  strlcpy(msg.firmware, FIRMWARE_VERSION, sizeof(msg.firmware));
   
-  String message;
-  serializeJson(doc, message);
+  uint8_t payload[WIRE_FRAME_MAX];
+  size_t length = Wire::encode(msg, payload, sizeof(payload));
   
-  mqttClient.publish(Topic::JOIN, message.c_str());
-  Serial.printf("Sent join request: %s\n", message.c_str());
+  mqttClient.publish(Topic::JOIN, payload, length);
+  Serial.printf("Sent join request: %.*s\n", (int)length, (const char*)payload);
 }
 
-void ClientMQTT::sendBuzz() {
-  if (!isConnected()) return;
+void ClientMQTT::setCodec(Wire::Codec newCodec) {
+  if (codec == newCodec) return;
+  codec = newCodec;
+  buzzFrameReady = false; // rebuilt in the new encoding
+  Serial.printf("Wire codec: %s\n", codec == Wire::Codec::BINARY ? "binary" : "json");
+}
+
+void ClientMQTT::prepareBuzzFrame() {
+  if (buzzFrameReady) return; // frame only depends on client ID and codec
+  
+  uint8_t payload[BUZZ_FRAME_SIZE];
+  uint16_t payloadLength;
+  uint8_t seqOffset;
+  uint8_t timeOffset;
+  
+  if (codec == Wire::Codec::BINARY) {
+    // Binary buzz message, sequence and timestamp patched in place
+    Wire::BuzzMessage msg;
+    strlcpy(msg.id, clientId.c_str(), sizeof(msg.id));
+    msg.seq = 0;
+    msg.hasTimestamp = true;
+    msg.hubTime = false;
+    msg.timestamp = 0;
+    msg.falseStart = false;
+    payloadLength = Wire::encode(msg, codec, payload, sizeof(payload));
+    seqOffset = Wire::buzzSeqOffset(strlen(msg.id));
+    timeOffset = Wire::buzzTimeOffset(strlen(msg.id));
+  } else {
+    // Payload with space-padded number fields: {"id":"C-1234","seq":    1,"t":         0}
+    int seqLength = snprintf((char*)payload, sizeof(payload), "{\"%s\":\"%s\",\"%s\":",
+                             JsonKey::ID, clientId.c_str(), JsonKey::SEQUENCE);
+    int timeLength = 0;
+    if (seqLength > 0 && seqLength + BUZZ_FRAME_SEQ_DIGITS < (int)sizeof(payload)) {
+      timeLength = snprintf((char*)payload + seqLength + BUZZ_FRAME_SEQ_DIGITS,
+                            sizeof(payload) - seqLength - BUZZ_FRAME_SEQ_DIGITS,
+                            ",\"%s\":", JsonKey::TIMESTAMP);
+    }
+    seqOffset = seqLength;
+    timeOffset = seqLength + BUZZ_FRAME_SEQ_DIGITS + timeLength;
+    payloadLength = (timeLength > 0) ? timeOffset + BUZZ_FRAME_TIME_DIGITS + 1 : 0;
+    if (payloadLength > 0 && payloadLength <= sizeof(payload)) {
+      memset(payload + seqOffset, ' ', BUZZ_FRAME_SEQ_DIGITS);
+      memset(payload + timeOffset, ' ', BUZZ_FRAME_TIME_DIGITS);
+      payload[payloadLength - 1] = '}';
+    } else {
+      payloadLength = 0;
+    }
+  }
   
-  StaticJsonDocument<200> doc;
-  doc[JsonKey::ID] = clientId;
-  doc[JsonKey::TIMESTAMP] = millis();
+  uint16_t topicLength = strlen(Topic::BUZZ);
+  uint16_t remainingLength = 2 + topicLength + payloadLength;
   
-  String message;
-  serializeJson(doc, message);
+  // Fixed header (1) + remaining length (1, frame stays below 128 bytes)
+  if (payloadLength == 0 || remainingLength > 127 || 2 + remainingLength > BUZZ_FRAME_SIZE) {
+    buzzFrameReady = false;
+    Serial.println("Buzz frame too large - using regular publish");
+    return;
+  }
+  
+  uint8_t pos = 0;
+  buzzFrame[pos++] = 0x30;  // PUBLISH, QoS 0, no retain
+  buzzFrame[pos++] = remainingLength;
+  buzzFrame[pos++] = topicLength >> 8;
+  buzzFrame[pos++] = topicLength & 0xFF;
+  memcpy(buzzFrame + pos, Topic::BUZZ, topicLength);
+  pos += topicLength;
+  memcpy(buzzFrame + pos, payload, payloadLength);
+  buzzFrameSeqOffset = pos + seqOffset;
+  buzzFrameTimeOffset = pos + timeOffset;
+  pos += payloadLength;
+  
+  buzzFrameLength = pos;
+  buzzFrameCodec = codec;
+  buzzFrameReady = true;
+  Serial.printf("Buzz frame ready (%d bytes, %s)\n", buzzFrameLength,
+                codec == Wire::Codec::BINARY ? "binary" : "json");
+}
+
+// Write a number right-aligned into a space-padded frame field
+static void patchNumberField(uint8_t* field, uint8_t width, uint32_t value) {
+  for (int8_t i = width - 1; i >= 0; i--) {
+    if (value > 0 || i == width - 1) {
+      field[i] = '0' + (value % 10);
+      value /= 10;
+    } else {
+      field[i] = ' ';
+    }
+  }
+}
+
+bool ClientMQTT::writeBuzzFrame(uint16_t seq, uint32_t pressTime) {
+  if (buzzFrameCodec == Wire::Codec::BINARY) {
+    // Little-endian fields, see wire_codec.h
+    buzzFrame[buzzFrameSeqOffset] = seq & 0xFF;
+    buzzFrame[buzzFrameSeqOffset + 1] = seq >> 8;
+    for (uint8_t i = 0; i < 4; i++) {
+      buzzFrame[buzzFrameTimeOffset + i] = (pressTime >> (8 * i)) & 0xFF;
+    }
+  } else {
+    patchNumberField(buzzFrame + buzzFrameSeqOffset, BUZZ_FRAME_SEQ_DIGITS, seq);
+    patchNumberField(buzzFrame + buzzFrameTimeOffset, BUZZ_FRAME_TIME_DIGITS, pressTime);
+  }
+  
+  return wifiClient.write(buzzFrame, buzzFrameLength) == buzzFrameLength;
+}
+
+bool ClientMQTT::transmitBuzz() {
+  // Hot path: patch and write the pre-built frame
+  if (buzzFrameReady && buzzFrameCodec == codec && !buzzIsOffline && !buzzFalseStart &&
+      writeBuzzFrame(buzzSeq, lastBuzzPressTime)) {
+    lastBuzzSendTime = millis();
+    return true;
+  }
+  
+  Wire::BuzzMessage msg;
+  strlcpy(msg.id, clientId.c_str(), sizeof(msg.id));
+  msg.seq = buzzSeq;
+  msg.hasTimestamp = true;
+  msg.hubTime = buzzIsOffline;
+  msg.timestamp = lastBuzzPressTime;
+  msg.falseStart = buzzFalseStart;
+  
+  uint8_t payload[WIRE_FRAME_MAX];
+  size_t length = Wire::encode(msg, codec, payload, sizeof(payload));
+  
+  bool sent = mqttClient.publish(Topic::BUZZ, payload, length);
+  lastBuzzSendTime = millis();
+  return sent;
+}
+
+void ClientMQTT::sendBuzz(int64_t pressTimeUs) {
+  uint32_t pressTime = (uint32_t)(pressTimeUs / 1000); // millis() time base
+  
+  // Offline - keep the press in RTC memory with its hub time for reconnect
+  if (!isConnected()) {
+    if (!canBufferBuzz()) return;
+    
+    offlineBuzz.seq = ++buzzSeq;
+    offlineBuzz.hubTime = hubClock.toRemote(pressTime);
+    offlineBuzz.magic = OFFLINE_BUZZ_MAGIC;
+    Serial.printf("Offline - buffered buzz #%d (hub time %u)\n", offlineBuzz.seq, offlineBuzz.hubTime);
+    return;
+  }
+  
+  // New buzz - retransmits reuse this sequence number and press time
+  buzzSeq++;
+  lastBuzzPressTime = pressTime;
+  buzzIsOffline = false;
+  buzzFalseStart = isFalseStart(pressTime);
+  buzzRetries = 0;
+  buzzPending = true;
+  
+  transmitBuzz();
+  uint32_t pressToWrite = (uint32_t)(esp_timer_get_time() - pressTimeUs);
+  Serial.printf("Sent buzz #%d (t=%u), press-to-write: %u us\n", buzzSeq, lastBuzzPressTime, pressToWrite);
+}
+
+void ClientMQTT::retransmitBuzz() {
+  if (!buzzPending || millis() - lastBuzzSendTime < BUZZ_RETRY_MS) return;
+  
+  if (buzzRetries >= BUZZ_RETRY_MAX) {
+    buzzPending = false;
+    Serial.printf("Buzz #%d not acked after %d retries, giving up\n", buzzSeq, buzzRetries);
+    return;
+  }
+  
+  buzzRetries++;
+  transmitBuzz();
+  Serial.printf("Retransmit buzz #%d (retry %d)\n", buzzSeq, buzzRetries);
+}
+
+void ClientMQTT::cancelBuzzRetransmit() {
+  buzzPending = false;
+  offlineBuzz.magic = 0;
+}
+
+bool ClientMQTT::canBufferBuzz() {
+  // Only brief drops during an open question, and only with a hub clock
+  // estimate to convert the press time
+  return gameIsOpen &&
+         hubClock.isSynced() &&
+         lastConnectedTime > 0 &&
+         millis() - lastConnectedTime < OFFLINE_BUZZ_MAX_MS &&
+         offlineBuzz.magic != OFFLINE_BUZZ_MAGIC;
+}
+
+bool ClientMQTT::hasBuzzInFlight() const {
+  return buzzPending || offlineBuzz.magic == OFFLINE_BUZZ_MAGIC;
+}
+
+void ClientMQTT::onJoined() {
+  joinAnswered = true;
+  deliverOfflineBuzz();
+}
+
+void ClientMQTT::deliverOfflineBuzz() {
+  if (offlineBuzz.magic != OFFLINE_BUZZ_MAGIC || !joinAnswered) return;
+  
+  // Age is only known in hub time - after a reset wait for the first sync
+  if (!hubClock.isSynced()) return;
+  offlineBuzz.magic = 0;
+  
+  // Only limiting the drop isn't enough - reconnect backoff or a reset can
+  // hold the press until a later question. A press "in the future" means
+  // the hub rebooted in between, also dropped (unsigned wrap).
+  uint32_t age = hubClock.toRemote(millis()) - offlineBuzz.hubTime;
+  if (age > OFFLINE_BUZZ_MAX_MS) {
+    Serial.printf("Offline buzz #%d dropped (%u ms old)\n", offlineBuzz.seq, age);
+    if (clientManager) {
+      clientManager->releaseBuzz();
+    }
+    return;
+  }
   
-  mqttClient.publish(Topic::BUZZ, message.c_str());
-  Serial.printf("Sent buzz: %s\n", message.c_str());
+  // Server decides whether it still counts for the current question
+  if (offlineBuzz.seq > buzzSeq) {
+    buzzSeq = offlineBuzz.seq; // restored after a reset
+  }
+  lastBuzzPressTime = offlineBuzz.hubTime;
+  buzzIsOffline = true;
+  buzzFalseStart = false; // hub time is judged by the server directly
+  buzzRetries = 0;
+  buzzPending = true;
+  
+  transmitBuzz();
+  Serial.printf("Delivered offline buzz #%d (hub time %u)\n", buzzSeq, lastBuzzPressTime);
 }
 
-void ClientMQTT::sendPing() {
+void ClientMQTT::sendPing(uint32_t echoTime) {
   if (!isConnected()) return;
   
-  StaticJsonDocument<100> doc;
-  doc[JsonKey::ID] = clientId;
+  Wire::PingMessage msg;
+  strlcpy(msg.id, clientId.c_str(), sizeof(msg.id));
+  msg.hasTimestamp = true;
+  msg.timestamp = millis();
+  
+  // Echo server time so the server can measure round-trip and clock offset
+  msg.hasEcho = echoTime > 0;
+  msg.echo = echoTime;
+  
+  uint8_t payload[WIRE_FRAME_MAX];
+  size_t length = Wire::encode(msg, codec, payload, sizeof(payload));
+  
+  mqttClient.publish(Topic::PING, payload, length);
+}
+
+bool ClientMQTT::onBuzzAck(uint16_t seq, uint32_t serverTime) {
+  if (!buzzPending || seq != buzzSeq) return false; // stale ack of an older buzz
+  
+  buzzPending = false;
+  
+  // Karn's rule: a retransmitted buzz gives no unambiguous round-trip
+  if (buzzRetries > 0) {
+    Serial.printf("Buzz #%d acked after %d retries\n", seq, buzzRetries);
+    return true;
+  }
   
-  String message;
-  serializeJson(doc, message);
+  uint32_t now = millis();
+  uint32_t rtt = now - lastBuzzSendTime;
+  hubClock.addSample(lastBuzzSendTime, serverTime, now);
   
-  mqttClient.publish(Topic::PING, message.c_str());
+  Serial.printf("Buzz rtt %u ms (best %u, jitter %u, offset %d)\n",
+                rtt, hubClock.getRtt(), hubClock.getJitter(), hubClock.getOffset());
+  return true;
+}
+
+void ClientMQTT::scheduleOpen(uint32_t hubOpenAt) {
+  if (!hubClock.isSynced()) {
+    Serial.println("No hub clock yet - unlocking on OPEN state instead");
+    return;
+  }
+  
+  openLocalTime = hubClock.toLocal(hubOpenAt);
+  openScheduled = true;
+  int32_t lead = (int32_t)(openLocalTime - millis());
+  if (lead > 0) {
+    Serial.printf("Question opens in %d ms\n", lead);
+  }
+  updateOpenSchedule();
+}
+
+void ClientMQTT::clearOpenSchedule() {
+  openScheduled = false;
+}
+
+void ClientMQTT::updateOpenSchedule() {
+  if (openScheduled && !gameIsOpen && (int32_t)(millis() - openLocalTime) >= 0) {
+    gameIsOpen = true;
+    Serial.printf("=== Question OPEN (announced instant, %u ms late) ===\n", 
+                  (uint32_t)(millis() - openLocalTime));
+  }
+}
+
+bool ClientMQTT::isFalseStart(uint32_t pressTime) const {
+  return openScheduled && (int32_t)(pressTime - openLocalTime) < 0;
+}
+
+bool ClientMQTT::isHubSynced() const {
+  return hubClock.isSynced();
+}
+
+uint32_t ClientMQTT::hubToLocal(uint32_t hubTime) const {
+  return hubClock.isSynced() ? hubClock.toLocal(hubTime) : hubTime;
+}
+
+uint32_t ClientMQTT::localToHub(uint32_t localTime) const {
+  return hubClock.isSynced() ? hubClock.toRemote(localTime) : localTime;
+}
+
+void ClientMQTT::onClockSync(uint32_t clientTime, uint32_t serverTime) {
+  hubClock.addSample(clientTime, serverTime, millis());
+  deliverOfflineBuzz(); // waiting for a hub clock after a reset
 }
 
 const String& ClientMQTT::getClientId() const {
@@ -175,51 +680,117 @@ const String& ClientMQTT::getClientId() const {
 }
 
 // MQTT Message handlers
-void handleAssignment(const String& payload) {
-  StaticJsonDocument<200> doc;
-  DeserializationError error = deserializeJson(doc, payload);
+// Phase side of a state or snapshot - open schedule and buzz frame
+static void applyPhase(Phase phase, bool hasOpenAt, uint32_t openAt) {
+  bool questionRunning = (phase == Phase::ARMED || phase == Phase::OPEN || phase == Phase::ANSWER);
   
-  if (error) {
-    Serial.printf("Assignment JSON parse error: %s\n", error.c_str());
+  // Update global gameIsOpen state - ARMED opens later at the announced instant
+  gameIsOpen = (phase == Phase::OPEN || phase == Phase::ANSWER);
+  
+  // The queue only exists while someone answers
+  if (phase != Phase::ANSWER) {
+    view.queueValid = false;
+  }
+  
+  if (clientMqtt) {
+    if (questionRunning) {
+      // Have the buzz frame ready before the first press
+      clientMqtt->prepareBuzzFrame();
+      if (hasOpenAt) {
+        clientMqtt->scheduleOpen(openAt);
+      }
+    } else {
+      clientMqtt->clearOpenSchedule();
+      clientMqtt->cancelBuzzRetransmit(); // question over, nothing left to deliver
+    }
+  }
+}
+
+// Reconnect snapshot - assignment, phase and our queue standing in one go
+static void handleSnapshot(const uint8_t* payload, size_t length) {
+  Wire::SnapshotMessage msg;
+  if (!Wire::decode(payload, length, msg)) {
+    Serial.println("Snapshot parse error");
     return;
   }
   
-  uint8_t slot = doc[JsonKey::SLOT];
-  String colorHex = doc[JsonKey::COLOR];
+  // Covers every state and queue up to its sequence - older ones still in
+  // flight get dropped, our queue mirror is rebuilt from the next full queue
+  enterEpoch(msg.epoch);
+  bool current = !view.stateKnown || !sequenceAfter(view.stateSeq, msg.seq);
+  if (current) {
+    view.stateKnown = true;
+    view.stateSeq = msg.seq;
+  }
+  if (!view.queueKnown || sequenceAfter(msg.seq, view.queueSeq)) {
+    view.queueKnown = true;
+    view.queueSeq = msg.seq;
+  }
+  view.queueValid = false;
   
-  // Parse color hex string (#RRGGBB)
-  if (colorHex.length() == 7 && colorHex[0] == '#') {
-    uint32_t colorValue = strtol(colorHex.substring(1).c_str(), NULL, 16);
-    Rgb color(
-      (colorValue >> 16) & 0xFF,
-      (colorValue >> 8) & 0xFF,
-      colorValue & 0xFF
-    );
-    
-    if (clientManager) {
-      clientManager->setAssignment(slot, color);
-    }
-    
-    Serial.printf("Assignment received: slot %d, color %s\n", slot, colorHex.c_str());
+  if (clientMqtt) {
+    clientMqtt->setCodec(Wire::Codec::BINARY);
+    clientMqtt->resetReceiveStats();
+  }
+  if (current) {
+    applyPhase(msg.phase, msg.hasOpenAt, msg.openAt);
+  }
+  
+  // Offline buzz goes out before restoring, so restore() sees it in flight
+  if (clientMqtt) {
+    clientMqtt->onJoined();
   }
+  if (clientManager) {
+    clientManager->restore(msg.slot, msg.color, msg.position > 0, msg.active);
+  }
+  
+  Serial.printf("Snapshot: %s, queue position %d\n", phaseToString(msg.phase), msg.position);
 }
 
-void handleGameState(const String& payload) {
-  StaticJsonDocument<200> doc;
-  DeserializationError error = deserializeJson(doc, payload);
+void handleAssignment(const uint8_t* payload, size_t length) {
+  if (Wire::isSnapshot(payload, length)) {
+    handleSnapshot(payload, length);
+    return;
+  }
   
-  if (error) return;
+  Wire::AssignMessage msg;
+  if (!Wire::decode(payload, length, msg)) {
+    Serial.println("Assignment parse error");
+    return;
+  }
   
-  String phaseStr = doc[JsonKey::PHASE];
-  bool locked = doc[JsonKey::LOCKED];
+  // Binary assignment - server accepted our binary codec
+  if (clientMqtt) {
+    clientMqtt->setCodec(Wire::isBinary(payload, length) ? Wire::Codec::BINARY : Wire::Codec::JSON);
+  }
   
-  Serial.printf("Game state: %s, locked: %s\n", phaseStr.c_str(), locked ? "true" : "false");
+  if (clientManager) {
+    clientManager->setAssignment(msg.slot, msg.color);
+  }
   
-  // Handle phase changes
-  Phase phase = stringToPhase(phaseStr.c_str());
+  // Joined - connection warm-up is over, count receive allocations from here
+  if (clientMqtt) {
+    clientMqtt->resetReceiveStats();
+    clientMqtt->onJoined();
+  }
   
-  // Update global gameIsOpen state
-  gameIsOpen = (phase == Phase::OPEN || phase == Phase::ANSWER);
+  Serial.printf("Assignment received: slot %d, color #%02X%02X%02X\n",
+                msg.slot, msg.color.r, msg.color.g, msg.color.b);
+}
+
+void handleGameState(const uint8_t* payload, size_t length) {
+  Wire::StateMessage msg;
+  if (!Wire::decode(payload, length, msg)) return;
+  
+  if (msg.hasSequence && !acceptStateSequence(msg.epoch, msg.seq)) {
+    Serial.printf("Stale state #%u dropped\n", msg.seq);
+    return;
+  }
+  Serial.printf("Game state: %s, locked: %s\n", phaseToString(msg.phase), msg.locked ? "true" : "false");
+  
+  // Handle phase changes
+  Phase phase = msg.phase;
+  applyPhase(phase, msg.hasOpenAt, msg.openAt);
   
   if (phase == Phase::OPEN && clientManager && clientManager->canBuzz()) {
     // Game is open for buzzing
@@ -227,66 +798,172 @@ void handleGameState(const String& payload) {
       // Keep idle state, ready to buzz
     }
   } else if (phase == Phase::READY) {
+    // Question boundary - report receive path allocations so far
+    if (clientMqtt) {
+      clientMqtt->logReceiveStats();
+    }
+    
     // New question, reset buzz state
     if (clientManager) {
+      clientManager->cancelScheduledState();
       clientManager->resetBuzzState();
       clientManager->setState(ClientState::IDLE);
     }
   }
 }
 
-void handleQueue(const String& payload) {
-  StaticJsonDocument<300> doc;
-  DeserializationError error = deserializeJson(doc, payload);
-  
-  if (error) return;
-  
-  String activeClient = doc[JsonKey::ACTIVE];
-  
-  if (clientManager && activeClient == clientMqtt->getClientId()) {
+// Queue changed - react if we're the one answering now
+static void onQueueChanged() {
+  const Wire::QueueMessage& queue = view.queue;
+  if (clientManager && queue.active >= 0 && clientMqtt->getClientId() == queue.order[queue.active]) {
     // This client is active
     clientManager->setState(ClientState::ACTIVE_TURN);
     Serial.println("I'm now active!");
   }
 }
 
-void handleCommand(const String& payload) {
-  StaticJsonDocument<200> doc;
-  DeserializationError error = deserializeJson(doc, payload);
+// Delta onto the queue we hold - false if it doesn't fit what we have
+static bool applyQueueDelta(const Wire::QueueDeltaMessage& delta) {
+  Wire::QueueMessage& queue = view.queue;
+  if (delta.op == Wire::QueueOp::PUSH) {
+    if (queue.length >= MAX_CLIENTS || delta.position > queue.length) return false;
+    for (uint8_t i = queue.length; i > delta.position; i--) {
+      memcpy(queue.order[i], queue.order[i - 1], sizeof(queue.order[i]));
+    }
+    strlcpy(queue.order[delta.position], delta.id, sizeof(queue.order[delta.position]));
+    queue.length++;
+  } else {
+    if (delta.position >= queue.length) return false;
+    for (uint8_t i = delta.position; i + 1 < queue.length; i++) {
+      memcpy(queue.order[i], queue.order[i + 1], sizeof(queue.order[i]));
+    }
+    queue.length--;
+  }
+  queue.active = delta.active < queue.length ? delta.active : -1;
+  return true;
+}
+
+void handleQueue(const uint8_t* payload, size_t length) {
+  if (Wire::isQueueDelta(payload, length)) {
+    Wire::QueueDeltaMessage delta;
+    if (!Wire::decode(payload, length, delta)) return;
+    
+    uint16_t base = view.queueSeq;
+    bool hadQueue = view.queueValid && view.queueKnown && view.epoch == delta.epoch;
+    if (!acceptQueueSequence(delta.epoch, delta.seq)) {
+      Serial.printf("Stale queue delta #%u dropped\n", delta.seq);
+      return;
+    }
+    
+    // Missed a queue update in between - wait for the next full queue
+    view.queueValid = hadQueue && base == delta.base && applyQueueDelta(delta);
+    if (!view.queueValid) {
+      Serial.printf("Queue delta #%u doesn't apply - waiting for full queue\n", delta.seq);
+      return;
+    }
+    onQueueChanged();
+    return;
+  }
   
-  if (error) return;
+  Wire::QueueMessage msg;
+  if (!Wire::decode(payload, length, msg)) return;
   
-  String cmd = doc[JsonKey::CMD];
-  String target = doc[JsonKey::TARGET];
+  if (msg.hasSequence && !acceptQueueSequence(msg.epoch, msg.seq)) {
+    Serial.printf("Stale queue #%u dropped\n", msg.seq);
+    return;
+  }
+  view.queue = msg;
+  view.queueValid = true;
+  onQueueChanged();
+}
+
+void handleCommand(const uint8_t* payload, size_t length) {
+  Wire::CommandMessage msg;
+  if (!Wire::decode(payload, length, msg)) return;
   
   // Check if command is for this client
-  if (target.length() > 0 && target != clientMqtt->getClientId()) {
+  if (msg.target[0] != '\0' && clientMqtt->getClientId() != msg.target) {
     return;
   }
   
+  // Effects with an announced start begin at that hub instant on every board
+  bool scheduled = msg.hasStart && clientMqtt->isHubSynced();
+  uint32_t localStart = scheduled ? clientMqtt->hubToLocal(msg.start) : millis();
+  
   if (clientManager) {
-    if (cmd == Command::CELEBRATE) {
-      clientManager->setState(ClientState::CELEBRATE);
-    } else if (cmd == Command::WRONG_FLASH) {
+    switch (msg.cmd) {
+      case CommandType::CELEBRATE:
+        clientManager->scheduleState(ClientState::CELEBRATE, localStart);
+        break;
+      case CommandType::WRONG_FLASH:
+        clientManager->scheduleState(ClientState::WRONG_FLASH, localStart);
+        break;
+      case CommandType::ANIM_ACTIVE:
+        clientManager->setState(ClientState::ACTIVE_TURN);
+        break;
+      case CommandType::LIGHT_WHITE:
+        clientManager->setState(ClientState::LOCKED_AFTER_BUZZ);
+        break;
+      case CommandType::IDLE_COLOR:
+        clientManager->setState(ClientState::IDLE);
+        break;
+      case CommandType::RESET:
+        // A late WRONG_FLASH must not start after the RESET it preceded
+        clientManager->cancelScheduledState();
+        clientManager->resetBuzzState();
+        clientManager->setState(ClientState::IDLE);
+        Serial.printf("Client RESET - can buzz again (gameIsOpen: %s)\n", gameIsOpen ? "true" : "false");
+        break;
+      case CommandType::PING_REQUEST:
+        // Respond to server ping right away - the reply is a clock sync sample
+        if (clientMqtt && clientMqtt->isConnected()) {
+          clientMqtt->sendPing(msg.timestamp);
+          Serial.println("Responded to server ping");
+        }
+        break;
+      case CommandType::NONE:
+        break;
+    }
+  }
+  
+  Serial.printf("Command received: %s\n", commandToString(msg.cmd));
+}
+
+void handleBuzzAck(const uint8_t* payload, size_t length) {
+  Wire::AckMessage msg;
+  if (!Wire::decode(payload, length, msg)) return;
+  
+  uint8_t position = msg.position;
+  uint32_t serverTime = msg.receiveTime;
+  uint16_t seq = msg.seq;
+  
+  // Ack for the buzz we are waiting on, not a late one for an older buzz
+  bool current = clientMqtt && clientMqtt->onBuzzAck(seq, serverTime);
+  
+  if (position > 0) {
+    Serial.printf("Buzz #%d confirmed by server - queue position %d\n", seq, position);
+    if (current && clientManager) {
+      clientManager->confirmBuzz();
+    }
+  } else if (msg.falseStart) {
+    // Pressed before the question opened - flash, then free to buzz again
+    Serial.printf("Buzz #%d was a FALSE START\n", seq);
+    if (current && clientManager) {
       clientManager->setState(ClientState::WRONG_FLASH);
-    } else if (cmd == Command::ANIM_ACTIVE) {
-      clientManager->setState(ClientState::ACTIVE_TURN);
-    } else if (cmd == Command::LIGHT_WHITE) {
-      clientManager->setState(ClientState::LOCKED_AFTER_BUZZ);
-    } else if (cmd == Command::IDLE_COLOR) {
-      clientManager->setState(ClientState::IDLE);
-    } else if (cmd == Command::RESET) {
-      clientManager->resetBuzzState();
-      clientManager->setState(ClientState::IDLE);
-      Serial.printf("Client RESET - can buzz again (gameIsOpen: %s)\n", gameIsOpen ? "true" : "false");
-    } else if (cmd == "PING_REQUEST") {
-      // Respond to server ping
-      if (clientMqtt && clientMqtt->isConnected()) {
-        clientMqtt->sendPing();
-        Serial.println("Responded to server ping");
-      }
+    }
+  } else {
+    Serial.printf("Buzz #%d not queued by server\n", seq);
+    if (current && clientManager) {
+      clientManager->releaseBuzz();
     }
   }
+}
+
+void handleClockSync(const uint8_t* payload, size_t length) {
+  Wire::SyncMessage msg;
+  if (!Wire::decode(payload, length, msg)) return;
   
-  Serial.printf("Command received: %s\n", cmd.c_str());
+  if (clientMqtt) {
+    clientMqtt->onClockSync(msg.echo, msg.serverTime);
+  }
 }
@@ -0,0 +1,78 @@
+#include "clock_sync.h"
+
+ClockSync::ClockSync() {
+  reset();
+}
+
+void ClockSync::reset() {
+  sampleCount = 0;
+  nextSample = 0;
+  offset = 0;
+  rtt = 0;
+  jitter = 0;
+}
+
+bool ClockSync::addSample(uint32_t localSend, uint32_t remoteTime, uint32_t localReceive) {
+  uint32_t sampleRtt = localReceive - localSend;
+  
+  // Reject stale or wrapped replies (echo of an old request, clock reset)
+  if (sampleRtt > CLOCK_SYNC_MAX_RTT_MS) {
+    return false;
+  }
+  
+  // Remote clock was read roughly half way through the round-trip
+  Sample& sample = samples[nextSample];
+  sample.offset = (int32_t)(remoteTime - (localSend + sampleRtt / 2));
+  sample.rtt = sampleRtt;
+  
+  nextSample = (nextSample + 1) % CLOCK_SYNC_WINDOW;
+  if (sampleCount < CLOCK_SYNC_WINDOW) {
+    sampleCount++;
+  }
+  
+  // Clock filter: the fastest round-trip saw the least queueing delay,
+  // so its offset is the most trustworthy one in the window
+  uint8_t best = 0;
+  for (uint8_t i = 1; i < sampleCount; i++) {
+    if (samples[i].rtt < samples[best].rtt) {
+      best = i;
+    }
+  }
+  offset = samples[best].offset;
+  rtt = samples[best].rtt;
+  
+  // Delivery jitter: how much slower than the best path round-trips are,
+  // smoothed with gain 1/8 (start conservative at half the first RTT)
+  uint32_t excess = sampleRtt - rtt;
+  if (sampleCount == 1) {
+    jitter = sampleRtt / 2;
+  } else {
+    jitter = (jitter * 7 + excess) / 8;
+  }
+  
+  return true;
+}
+
+bool ClockSync::isSynced() const {
+  return sampleCount > 0;
+}
+
+int32_t ClockSync::getOffset() const {
+  return offset;
+}
+
+uint32_t ClockSync::getRtt() const {
+  return rtt;
+}
+
+uint32_t ClockSync::getJitter() const {
+  return jitter;
+}
+
+uint32_t ClockSync::toLocal(uint32_t remoteTime) const {
+  return remoteTime - (uint32_t)offset;
+}
+
+uint32_t ClockSync::toRemote(uint32_t localTime) const {
+  return localTime + (uint32_t)offset;
+}
@@ -0,0 +1,123 @@
+#include "event_loop.h"
+
+EventLoop eventLoop;
+
+static void logLoopStats() {
+  eventLoop.logStats();
+  eventLoop.resetStats();
+}
+
+EventLoop::EventLoop() : timerCount(0), task(nullptr), pollMs(EVENT_POLL_IDLE_MS), wakeups(0), eventWakeups(0) {
+}
+
+void EventLoop::begin() {
+  task = xTaskGetCurrentTaskHandle();
+  addTimer("stats", EVENT_STATS_INTERVAL_MS, logLoopStats);
+}
+
+void EventLoop::wake() {
+  if (task) {
+    xTaskNotifyGive(task);
+  }
+}
+
+void IRAM_ATTR EventLoop::wakeFromISR() {
+  if (!task) return;
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(task, &woken);
+  if (woken) {
+    portYIELD_FROM_ISR();
+  }
+}
+
+uint8_t EventLoop::addTimer(const char* name, uint32_t periodMs, TimerCallback callback) {
+  if (timerCount >= EVENT_TIMER_MAX) {
+    Serial.printf("No timer slot left for %s\n", name);
+    return NO_TIMER;
+  }
+  Timer& timer = timers[timerCount];
+  timer.name = name;
+  timer.callback = callback;
+  timer.periodUs = periodMs * 1000;
+  timer.dueUs = micros() + timer.periodUs;
+  timer.fires = 0;
+  timer.maxLateUs = 0;
+  timer.totalLateUs = 0;
+  return timerCount++;
+}
+
+void EventLoop::setPeriod(uint8_t timer, uint32_t periodMs) {
+  if (timer >= timerCount) return;
+  timers[timer].periodUs = periodMs * 1000;
+  timers[timer].dueUs = micros();
+}
+
+void EventLoop::setPollInterval(uint16_t ms) {
+  pollMs = ms;
+}
+
+void EventLoop::run() {
+  for (uint8_t i = 0; i < timerCount; i++) {
+    Timer& timer = timers[i];
+    uint32_t now = micros();
+    int32_t late = (int32_t)(now - timer.dueUs);
+    if (late < 0) continue;
+    
+    timer.fires++;
+    timer.totalLateUs += late;
+    if ((uint32_t)late > timer.maxLateUs) {
+      timer.maxLateUs = late;
+    }
+    
+    // Keep the phase, but don't replay periods missed entirely
+    timer.dueUs += timer.periodUs;
+    if ((int32_t)(now - timer.dueUs) >= 0) {
+      timer.dueUs = now + timer.periodUs;
+    }
+    timer.callback();
+  }
+}
+
+uint32_t EventLoop::msUntilNextTimer() const {
+  uint32_t now = micros();
+  uint32_t next = UINT32_MAX;
+  for (uint8_t i = 0; i < timerCount; i++) {
+    int32_t untilDue = (int32_t)(timers[i].dueUs - now);
+    if (untilDue <= 0) return 0;
+    uint32_t ms = (untilDue + 999) / 1000;
+    if (ms < next) next = ms;
+  }
+  return next;
+}
+
+void EventLoop::wait(uint32_t limitMs) {
+  uint32_t sleepMs = msUntilNextTimer();
+  if (pollMs < sleepMs) sleepMs = pollMs;
+  if (limitMs < sleepMs) sleepMs = limitMs;
+  
+  wakeups++;
+  if (sleepMs == 0) return;
+  if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(sleepMs)) > 0) {
+    eventWakeups++;
+  }
+}
+
+void EventLoop::logStats() {
+  Serial.printf("Loop: %u wakeups, %u by events\n", wakeups, eventWakeups);
+  for (uint8_t i = 0; i < timerCount; i++) {
+    const Timer& timer = timers[i];
+    if (timer.fires == 0) continue;
+    Serial.printf("  %s: %u fires, late avg %u max %u us\n", timer.name, timer.fires,
+                  (uint32_t)(timer.totalLateUs / timer.fires), timer.maxLateUs);
+  }
+}
+
+void EventLoop::resetStats() {
+  wakeups = 0;
+  eventWakeups = 0;
+  for (uint8_t i = 0; i < timerCount; i++) {
+    timers[i].fires = 0;
+    timers[i].maxLateUs = 0;
+    timers[i].totalLateUs = 0;
+  }
+}
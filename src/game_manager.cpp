@@ -1,76 +1,83 @@
 #include "game_manager.h"
 #include "mqtt_server.h"
 #include "led_controller.h"
-#include <ArduinoJson.h>
+#include "scheduler.h"
+#include "event_loop.h"
 
 // Global instances
-ButtonHandler* buttonHandler = nullptr;
 GameManager* gameManager = nullptr;
 
-// ButtonHandler Implementation
-ButtonHandler::ButtonHandler(Bounce& btn) : button(btn), lastButtonPress(0), buttonHeld(false) {
+// Deferred actions - run from scheduler.run() in the loop, never block the broker
+static void sendWrongReset(uint8_t client) {
+  publishCommand(makeCommand(CommandType::RESET, gameClients[client].id));
+  logPrintf("Sent RESET to %s\n", gameClients[client].id);
 }
 
-ButtonPress ButtonHandler::checkButtonPress() {
-  button.update();
-  
-  // Button pressed
-  if (button.fell()) {
-    lastButtonPress = millis();
-    buttonHeld = false;
-    return ButtonPress::NONE;
-  }
-  
-  // Button held - check for long press
-  if (button.read() == LOW && lastButtonPress && !buttonHeld) {
-    uint32_t holdTime = millis() - lastButtonPress;
-    
-    if (holdTime >= VERY_LONG_PRESS_MS) {
-      buttonHeld = true;
-      return ButtonPress::VERY_LONG;
-    } else if (holdTime >= LONG_PRESS_MS) {
-      buttonHeld = true;
-      return ButtonPress::LONG;
-    }
+static void openQuestionAction(uint8_t) {
+  if (gameManager) gameManager->openQuestion();
+}
+
+static void finishCelebration(uint8_t) {
+  if (gameManager && currentPhase == Phase::RESET) gameManager->resetToReady();
+}
+
+static void bootTimeout(uint8_t) {
+  if (!gameManager || currentPhase != Phase::BOOT) return;
+  currentPhase = Phase::LOBBY;
+  if (ledController) {
+    ledController->clearAllLEDs();
   }
-  
-  // Button released
-  if (button.rose()) {
-    if (!buttonHeld && lastButtonPress) {
-      uint32_t pressTime = millis() - lastButtonPress;
-      lastButtonPress = 0;
-      buttonHeld = false;
-      
-      if (pressTime < SHORT_PRESS_MAX_MS) {
-        return ButtonPress::SHORT;
-      }
-    }
-    lastButtonPress = 0;
-    buttonHeld = false;
+  Serial.println("=== PHASE: LOBBY ===");
+  gameManager->publishGameState();
+}
+
+static void renderPhaseFrame() {
+  if (gameManager) gameManager->renderPhase();
+}
+
+// LED frame period per phase - each animation draws one step per frame
+static uint16_t framePeriodFor(Phase phase) {
+  switch (phase) {
+    case Phase::LOBBY: return 300;                        // Langsam: 300ms pro LED
+    case Phase::READY:
+    case Phase::ARMED: return 150;                        // Mittlere Geschwindigkeit
+    case Phase::OPEN: return PULSE_SPEED_MS;              // Same timing as client pulse
+    case Phase::ANSWER: return 100;
+    case Phase::RESET: return CELEBRATION_FRAME_MS;
+    default: return 500;
   }
-  
-  return ButtonPress::NONE;
+}
+
+// Broker polled tightly only while buzzes can arrive
+static bool phaseIsLive(Phase phase) {
+  return phase == Phase::ARMED || phase == Phase::OPEN || phase == Phase::ANSWER;
 }
 
 // GameManager Implementation
-void GameManager::handleButtonPress(ButtonPress press) {
-  switch(press) {
+void GameManager::begin() {
+  framePhase = currentPhase;
+  frameTimer = eventLoop.addTimer("leds", framePeriodFor(currentPhase), renderPhaseFrame);
+  
+  // Auto-transition to LOBBY if nobody moves on from BOOT
+  scheduler.after(BOOT_LOBBY_TIMEOUT_MS, bootTimeout);
+}
+
+// Main button walks through the game with press lengths, the dedicated
+// buttons judge an answer on the press edge
+void GameManager::handleButtonEvent(const ButtonEvent& event) {
+  logPrintf("%s press detected (%u ms after the edge)\n", buttonPressToString(event.press),
+            (uint32_t)(millis() - event.pressTime));
+  
+  switch(event.press) {
     case ButtonPress::SHORT:
-      Serial.println("SHORT press detected");
-      if (currentPhase == Phase::LOBBY && gameClientCount >= MIN_CLIENTS_TO_START) {
-        currentPhase = Phase::READY;
-        gameLocked = true;
-        Serial.println("=== PHASE: READY ===");
-        publishGameState();
-      } else if (currentPhase == Phase::READY) {
-        startQuestion();
-      } else if (currentPhase == Phase::ANSWER) {
+      if (currentPhase == Phase::ANSWER) {
         nextClient();
+      } else {
+        advancePhase();
       }
       break;
       
     case ButtonPress::LONG:
-      Serial.println("LONG press detected");
       if (currentPhase == Phase::ANSWER) {
         correctAnswer();
       } else {
@@ -79,32 +86,60 @@ void GameManager::handleButtonPress(ButtonPress press) {
       break;
       
     case ButtonPress::VERY_LONG:
-      Serial.println("VERY LONG press detected - UNLOCK GAME");
+      Serial.println("UNLOCK GAME");
       gameLocked = false;
       publishGameState();
       break;
       
+    case ButtonPress::NEXT:
+      // "Nächster Client" / "Falsche Antwort"
+      if (currentPhase == Phase::ANSWER) {
+        nextClient();
+      }
+      break;
+      
+    case ButtonPress::CORRECT:
+      // "Richtige Antwort" / "Weiter"
+      if (currentPhase == Phase::ANSWER) {
+        correctAnswer();
+      } else {
+        advancePhase();
+      }
+      break;
+      
     default:
       break;
   }
 }
 
+// LOBBY -> READY -> question
+void GameManager::advancePhase() {
+  if (currentPhase == Phase::LOBBY && gameClientCount >= MIN_CLIENTS_TO_START) {
+    currentPhase = Phase::READY;
+    gameLocked = true;
+    Serial.println("=== PHASE: READY ===");
+    publishGameState();
+  } else if (currentPhase == Phase::READY) {
+    startQuestion();
+  }
+}
+
+// Phase changes restart the LED frame timer at the new phase's rate, so the
+// first frame of the new phase is drawn right away
 void GameManager::handlePhase() {
+  if (currentPhase == framePhase) return;
+  framePhase = currentPhase;
+  eventLoop.setPeriod(frameTimer, framePeriodFor(currentPhase));
+  setNetworkPollInterval(phaseIsLive(currentPhase) ? EVENT_POLL_ACTIVE_MS : EVENT_POLL_IDLE_MS);
+}
+
+void GameManager::renderPhase() {
   if (!ledController) return;
   
   switch(currentPhase) {
     case Phase::BOOT:
-      // Boot phase - LEDs off, waiting for manual transition
+      // Boot phase - LEDs off until the boot timeout moves on to LOBBY
       ledController->clearAllLEDs();
-      
-      // Auto-transition to LOBBY after 15 seconds
-      static uint32_t bootStart = millis();
-      if (millis() - bootStart > 15000) {
-        currentPhase = Phase::LOBBY;
-        ledController->clearAllLEDs();
-        Serial.println("=== PHASE: LOBBY ===");
-        publishGameState();
-      }
       break;
       
     case Phase::LOBBY:
@@ -117,6 +152,11 @@ void GameManager::handlePhase() {
       ledController->animateReadyPingPong();
       break;
       
+    case Phase::ARMED:
+      // Keep ready animation until the announced open instant
+      ledController->animateReadyPingPong();
+      break;
+      
     case Phase::OPEN:
       ledController->animateOpen();
       break;
@@ -127,11 +167,12 @@ void GameManager::handlePhase() {
       break;
       
     case Phase::RESET:
-      // Celebration phase - show rainbow animation on server too
-      static uint32_t lastUpdate = 0;
-      static uint16_t animStep = 0;
-      
-      if (millis() - lastUpdate > 50) {
+      // Celebration phase - show rainbow animation on server too, frame-locked
+      // to the start instant sent to the client. finishCelebration ends it.
+      if ((int32_t)(millis() - celebrationStart) >= 0 &&
+          (millis() - celebrationStart) / CELEBRATION_FRAME_MS != celebrationFrame) {
+        celebrationFrame = (millis() - celebrationStart) / CELEBRATION_FRAME_MS;
+        uint16_t animStep = celebrationFrame * 5;
         for (uint16_t i = 0; i < LED_COUNT; i++) {
           uint8_t hue = (animStep + i * (256 / LED_COUNT)) & 255;
           
@@ -155,14 +196,6 @@ void GameManager::handlePhase() {
           ledController->setPixelColor(i, rainbowColor);
         }
         ledController->showLEDs();
-        animStep += 5;
-        lastUpdate = millis();
-      }
-      
-      // Wait for animation to complete
-      if (celebrationStart > 0 && millis() - celebrationStart > CELEBRATION_DURATION_MS) {
-        celebrationStart = 0;
-        resetToReady();
       }
       break;
       
@@ -176,16 +209,15 @@ void GameManager::resetGame() {
   currentPhase = Phase::LOBBY;
   gameLocked = false;
   
+  // Drop pending phase changes
+  scheduler.cancel(openQuestionAction);
+  scheduler.cancel(finishCelebration);
+  
   // Clear buzz queue
-  memset(buzzQueue, 0, sizeof(buzzQueue));
-  queueLength = 0;
+  cancelBuzzWindow();
+  buzzQueue.clear(); // also resets every client's buzz state
   activeClientIndex = -1;
   
-  // Reset client buzz states
-  for (uint8_t i = 0; i < gameClientCount; i++) {
-    gameClients[i].buzzed = false;
-  }
-  
   if (ledController) {
     ledController->clearAllLEDs();
   }
@@ -195,74 +227,64 @@ void GameManager::resetGame() {
 }
 
 void GameManager::startQuestion() {
+  // Announce the open instant ahead of time - synced clients unlock together
+  currentPhase = Phase::ARMED;
+  questionArmTime = millis();
+  questionOpenTime = questionArmTime + QUESTION_ARM_LEAD_MS;
+  resetAirStats();
+  logPrintf("=== PHASE: ARMED (opens at %u) ===\n", questionOpenTime);
+  publishGameState();
+  scheduler.cancel(openQuestionAction);
+  scheduler.at(questionOpenTime, openQuestionAction);
+}
+
+void GameManager::openQuestion() {
+  if (currentPhase != Phase::ARMED) return;
   currentPhase = Phase::OPEN;
   Serial.println("=== PHASE: OPEN ===");
-  publishGameState();
+  publishGameState(); // for clients without hub clock sync
 }
 
 void GameManager::nextClient() {
   // Wrong answer - remove current client from queue and reset them
-  if (activeClientIndex >= 0 && activeClientIndex < queueLength) {
-    String wrongClientId = buzzQueue[activeClientIndex];
+  if (activeClientIndex >= 0 && activeClientIndex < buzzQueue.size()) {
+    uint8_t wrongClient = buzzQueue.at(activeClientIndex);
+    const char* wrongClientId = gameClients[wrongClient].id;
     
     // Send WRONG_FLASH command to current client
-    StaticJsonDocument<200> doc;
-    doc[JsonKey::CMD] = Command::WRONG_FLASH;
-    doc[JsonKey::TARGET] = wrongClientId;
+    Wire::CommandMessage flash = makeCommand(CommandType::WRONG_FLASH, wrongClientId);
+    flash.hasStart = true;
+    flash.start = millis() + EFFECT_START_LEAD_MS;
+    publishCommand(flash);
+    logPrintf("Sent WRONG_FLASH to %s\n", wrongClientId);
     
-    String message;
-    serializeJson(doc, message);
-    mqttBroker.publish(Topic::CMD, message.c_str());
-    Serial.printf("Sent WRONG_FLASH to %s\n", wrongClientId.c_str());
-    
-    // Also send RESET command after a short delay to ensure client can buzz again
-    delay(100); // Small delay to ensure WRONG_FLASH is processed first
-    StaticJsonDocument<200> resetDoc;
-    resetDoc[JsonKey::CMD] = Command::RESET;
-    resetDoc[JsonKey::TARGET] = wrongClientId;
-    
-    String resetMessage;
-    serializeJson(resetDoc, resetMessage);
-    mqttBroker.publish(Topic::CMD, resetMessage.c_str());
-    Serial.printf("Sent RESET to %s\n", wrongClientId.c_str());
+    // Also send RESET once the flash has played out to ensure client can buzz
+    // again - clients end the flash themselves, this catches a lost WRONG_FLASH
+    scheduler.after(WRONG_RESET_DELAY_MS, sendWrongReset, wrongClient);
     
     // Reset client's buzzed state (allow them to buzz again)
-    for (uint8_t i = 0; i < gameClientCount; i++) {
-      if (gameClients[i].id == wrongClientId) {
-        gameClients[i].buzzed = false;
-        Serial.printf("Reset %s - can buzz again\n", wrongClientId.c_str());
-        break;
-      }
-    }
+    buzzQueue.clearBuzzed(wrongClient);
+    logPrintf("Reset %s - can buzz again\n", wrongClientId);
     
-    // Remove client from queue (shift all following clients forward)
-    for (uint8_t i = activeClientIndex; i < queueLength - 1; i++) {
-      buzzQueue[i] = buzzQueue[i + 1];
-    }
-    queueLength--;
+    // Remove client from queue - the answering client is the front
+    buzzQueue.remove(activeClientIndex);
     
     // activeClientIndex stays the same (next client is now at same index)
     // Check if there's still a client at current index
-    if (activeClientIndex < queueLength) {
-      String nextClientId = buzzQueue[activeClientIndex];
+    if (activeClientIndex < buzzQueue.size()) {
+      const char* nextClientId = gameClients[buzzQueue.at(activeClientIndex)].id;
       
       // Send ANIM_ACTIVE command to next client
-      StaticJsonDocument<200> nextDoc;
-      nextDoc[JsonKey::CMD] = Command::ANIM_ACTIVE;
-      nextDoc[JsonKey::TARGET] = nextClientId;
-      
-      String nextMessage;
-      serializeJson(nextDoc, nextMessage);
-      mqttBroker.publish(Topic::CMD, nextMessage.c_str());
-      Serial.printf("Sent ANIM_ACTIVE to next client: %s\n", nextClientId.c_str());
+      publishCommand(makeCommand(CommandType::ANIM_ACTIVE, nextClientId));
+      logPrintf("Sent ANIM_ACTIVE to next client: %s\n", nextClientId);
       
       // Update server LEDs
       if (ledController) {
         ledController->updateServerLEDs();
       }
       
-      // Publish updated queue
-      publishBuzzQueue();
+      // Publish updated queue - the answering client was popped
+      publishQueueDelta(Wire::QueueOp::POP, activeClientIndex);
     } else {
       // No more clients in queue - back to OPEN phase
       activeClientIndex = -1;
@@ -278,23 +300,24 @@ void GameManager::nextClient() {
 
 void GameManager::correctAnswer() {
   // Send celebration command to active client
-  if (activeClientIndex >= 0 && activeClientIndex < queueLength) {
-    String activeClientId = buzzQueue[activeClientIndex];
+  if (activeClientIndex >= 0 && activeClientIndex < buzzQueue.size()) {
+    const char* activeClientId = gameClients[buzzQueue.at(activeClientIndex)].id;
     
-    // Send celebrate command via MQTT
-    StaticJsonDocument<200> doc;
-    doc[JsonKey::CMD] = Command::CELEBRATE;
-    doc[JsonKey::TARGET] = activeClientId;
+    // Send celebrate command via MQTT - celebration starts at the same hub
+    // instant on client and server strip
+    uint32_t start = millis() + EFFECT_START_LEAD_MS;
+    Wire::CommandMessage celebrate = makeCommand(CommandType::CELEBRATE, activeClientId);
+    celebrate.hasStart = true;
+    celebrate.start = start;
+    publishCommand(celebrate);
+    logPrintf("Sent celebrate command to %s\n", activeClientId);
     
-    String message;
-    serializeJson(doc, message);
-    
-    mqttBroker.publish(Topic::CMD, message.c_str());
-    Serial.printf("Sent celebrate command to %s\n", activeClientId.c_str());
-    
-    // Set celebration phase with delay
+    // Set celebration phase, back to READY once the animation completed
     currentPhase = Phase::RESET;
-    celebrationStart = millis();
+    celebrationStart = start;
+    celebrationFrame = UINT32_MAX;
+    scheduler.cancel(finishCelebration);
+    scheduler.at(start + CELEBRATION_DURATION_MS, finishCelebration);
     Serial.println("=== CELEBRATION - waiting for animation ===");
     return; // Don't reset immediately
   }
@@ -305,70 +328,129 @@ void GameManager::correctAnswer() {
 
 void GameManager::resetToReady() {
   // Correct answer - reset for next question
-  memset(buzzQueue, 0, sizeof(buzzQueue));
-  queueLength = 0;
+  cancelBuzzWindow();
+  buzzQueue.clear(); // also resets every client's buzz state
   activeClientIndex = -1;
   
-  // Reset client buzz states
-  for (uint8_t i = 0; i < gameClientCount; i++) {
-    gameClients[i].buzzed = false;
-  }
-  
   currentPhase = Phase::READY;
   if (ledController) {
     ledController->clearAllLEDs();
   }
   Serial.println("=== CORRECT ANSWER - READY for next question ===");
+  logAirStats();
   publishGameState();
 }
 
 void GameManager::sendPingToAllClients() {
-  if (millis() - lastPingTime < PING_INTERVAL_MS) {
-    return; // Not time for ping yet
-  }
-  
-  lastPingTime = millis();
-  
   // Send ping request to all connected clients
-  StaticJsonDocument<100> doc;
-  doc[JsonKey::CMD] = "PING_REQUEST";
-  doc[JsonKey::TIMESTAMP] = millis();
-  
-  String message;
-  serializeJson(doc, message);
-  
-  mqttBroker.publish(Topic::CMD, message.c_str());
-  Serial.printf("Sent ping to all clients (count: %d)\n", gameClientCount);
+  Wire::CommandMessage ping = makeCommand(CommandType::PING_REQUEST);
+  ping.hasTimestamp = true;
+  ping.timestamp = millis();
+  publishCommand(ping);
+  logPrintf("Sent ping to all clients (count: %d)\n", gameClientCount);
 }
 
 void GameManager::publishGameState() {
-  StaticJsonDocument<200> doc;
-  doc[JsonKey::PHASE] = phaseToString(currentPhase);
-  doc[JsonKey::LOCKED] = gameLocked;
-  doc["gameClientCount"] = gameClientCount;
-  
-  String message;
-  serializeJson(doc, message);
-  
-  mqttBroker.publish(Topic::STATE, message.c_str(), true); // retained
-  Serial.printf("Published game state: %s\n", message.c_str());
+  stateDirty = true;
 }
 
 void GameManager::publishBuzzQueue() {
-  StaticJsonDocument<300> doc;
-  JsonArray order = doc.createNestedArray(JsonKey::ORDER);
-  
-  for (uint8_t i = 0; i < queueLength; i++) {
-    order.add(buzzQueue[i]);
+  queueDirty = true;
+  deltaPending = false;
+}
+
+// One push or pop goes out as a delta - a second change in the same tick, or
+// a client that can't apply deltas, gets the whole queue instead
+void GameManager::publishQueueDelta(Wire::QueueOp op, uint8_t position) {
+  if (queueDirty || deltaPending || queueSequence == 0 || !broadcastQueueDeltas()) {
+    publishBuzzQueue();
+    return;
+  }
+  deltaPending = true;
+  pendingOp = op;
+  pendingPosition = position;
+}
+
+// Several mutations in one tick cost a single state and queue publish, built
+// from the final values
+void GameManager::flushPublishes() {
+  if (stateDirty) {
+    stateDirty = false;
+    sendGameState();
+  }
+  if (queueDirty) {
+    queueDirty = false;
+    sendBuzzQueue();
+  } else if (deltaPending) {
+    deltaPending = false;
+    sendQueueDelta();
   }
+}
+
+uint16_t GameManager::stateEpoch() const {
+  return epoch;
+}
+
+uint16_t GameManager::stateSequence() const {
+  return sequence;
+}
+
+void GameManager::sendGameState() {
+  Wire::StateMessage msg;
+  msg.phase = currentPhase;
+  msg.locked = gameLocked;
+  msg.hasOpenAt = (currentPhase == Phase::ARMED || currentPhase == Phase::OPEN || currentPhase == Phase::ANSWER);
+  msg.openAt = questionOpenTime;
+  msg.clientCount = gameClientCount;
+  msg.hasSequence = true;
+  msg.epoch = epoch;
+  msg.seq = ++sequence;
   
-  if (activeClientIndex >= 0 && activeClientIndex < queueLength) {
-    doc[JsonKey::ACTIVE] = buzzQueue[activeClientIndex];
+  Wire::Codec codec = broadcastCodec();
+  size_t length = publishMessage(Topic::STATE, msg, codec, true); // retained
+  logPrintf("Published game state #%u: %s, locked: %s (%u bytes %s)\n", msg.seq, phaseToString(currentPhase),
+            gameLocked ? "true" : "false", (unsigned)length, codec == Wire::Codec::BINARY ? "binary" : "json");
+}
+
+void GameManager::sendBuzzQueue() {
+  Wire::QueueMessage msg;
+  msg.length = buzzQueue.size();
+  msg.active = (activeClientIndex >= 0 && activeClientIndex < buzzQueue.size()) ? activeClientIndex : -1;
+  for (uint8_t i = 0; i < buzzQueue.size(); i++) {
+    strlcpy(msg.order[i], gameClients[buzzQueue.at(i)].id, sizeof(msg.order[i]));
   }
+  msg.hasSequence = true;
+  msg.epoch = epoch;
+  msg.seq = ++sequence;
+  queueSequence = msg.seq;
   
-  String message;
-  serializeJson(doc, message);
+  Wire::Codec codec = broadcastCodec();
+  size_t length = publishMessage(Topic::QUEUE, msg, codec);
+  logPrintf("Published buzz queue #%u: %d entries, active %d (%u bytes %s)\n", msg.seq, buzzQueue.size(), msg.active,
+            (unsigned)length, codec == Wire::Codec::BINARY ? "binary" : "json");
+}
+
+void GameManager::sendQueueDelta() {
+  Wire::QueueDeltaMessage msg;
+  msg.epoch = epoch;
+  msg.seq = ++sequence;
+  msg.base = queueSequence;
+  msg.op = pendingOp;
+  msg.position = pendingPosition;
+  msg.active = (activeClientIndex >= 0 && activeClientIndex < buzzQueue.size()) ? activeClientIndex : -1;
+  msg.id[0] = '\0';
+  if (pendingOp == Wire::QueueOp::PUSH && pendingPosition < buzzQueue.size()) {
+    strlcpy(msg.id, gameClients[buzzQueue.at(pendingPosition)].id, sizeof(msg.id));
+  }
+  queueSequence = msg.seq;
   
-  mqttBroker.publish(Topic::QUEUE, message.c_str());
-  Serial.printf("Published buzz queue: %s\n", message.c_str());
+  OutboundBuffer* buffer = acquireOutbound();
+  if (!buffer) return;
+  buffer->length = Wire::encode(msg, buffer->data, sizeof(buffer->data));
+  if (buffer->length > 0) {
+    postOutbound(Topic::QUEUE, buffer->data, buffer->length, false);
+  }
+  logPrintf("Published queue delta #%u: %s at %d, active %d (%u bytes)\n", msg.seq,
+            pendingOp == Wire::QueueOp::PUSH ? "push" : "pop", pendingPosition, msg.active, (unsigned)buffer->length);
+  releaseOutbound(buffer);
 }
@@ -0,0 +1,60 @@
+#include "heap_counter.h"
+
+#ifdef HEAP_COUNTER
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static volatile TaskHandle_t watchedTask = nullptr;
+static volatile uint32_t allocationCount = 0;
+
+// Only the watched task writes the counter, other tasks just pass through
+static inline void countAllocation() {
+  if (watchedTask != nullptr && xTaskGetCurrentTaskHandle() == watchedTask) {
+    allocationCount++;
+  }
+}
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+  countAllocation();
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  countAllocation();
+  return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+  countAllocation();
+  return __real_realloc(ptr, size);
+}
+}
+
+namespace HeapCounter {
+  void watchCurrentTask() {
+    watchedTask = xTaskGetCurrentTaskHandle();
+  }
+
+  uint32_t count() {
+    return allocationCount;
+  }
+
+  bool isEnabled() {
+    return true;
+  }
+}
+
+#else
+
+namespace HeapCounter {
+  void watchCurrentTask() {}
+  uint32_t count() { return 0; }
+  bool isEnabled() { return false; }
+}
+
+#endif
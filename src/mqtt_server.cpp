@@ -1,264 +1,802 @@
 #include "mqtt_server.h"
 #include "led_controller.h"
 #include "game_manager.h"
-#include <ArduinoJson.h>
+#include "wire_codec.h"
+#include <stdarg.h>
 
 // Global variables
 QuizMQTTBroker mqttBroker;
 ClientInfo gameClients[MAX_CLIENTS];
 uint8_t gameClientCount = 0;
-String buzzQueue[MAX_CLIENTS];
-uint8_t queueLength = 0;
+BuzzQueue buzzQueue;
+
+// Buzz arbitration window - buzzes held until the window closes
+struct PendingBuzz {
+  uint8_t client;
+  uint32_t pressTime;
+};
+static PendingBuzz pendingBuzzes[MAX_CLIENTS];
+static uint8_t pendingBuzzCount = 0;
+static uint32_t buzzWindowStart = 0;
+static uint16_t buzzWindowLength = 0;
 
 // Forward declaration
 extern GameManager* gameManager;
 int8_t activeClientIndex = -1;
 Phase currentPhase = Phase::BOOT;
+uint32_t questionOpenTime = 0;
+uint32_t questionArmTime = 0;
 bool gameLocked = false;
 
-// MQTT Broker Implementation
+// MQTT Broker Implementation - network task, so no logPrintf (its line
+// buffer belongs to the loop task) and no game state
 void QuizMQTTBroker::on_connected(const char * client_id) {
-  Serial.printf("MQTT Client connected: %s\n", client_id);
+  Serial.print("MQTT Client connected: ");
+  Serial.println(client_id);
 }
 
 void QuizMQTTBroker::on_disconnected(const char * client_id) {
-  Serial.printf("MQTT Client disconnected: %s\n", client_id);
+  Serial.print("MQTT Client disconnected: ");
+  Serial.println(client_id);
   // Note: Game client cleanup handled in main loop via timeouts
 }
 
-// MQTT Message Handlers
-void handleClientJoin(const String& payload) {
-  StaticJsonDocument<200> doc;
-  DeserializationError error = deserializeJson(doc, payload);
+// Command airtime of the current question round
+static AirStats airStats = {};
+
+// Commands raised during one loop() tick, sent together by flushCommands()
+constexpr int8_t QUEUED_BROADCAST = -1;
+constexpr int8_t QUEUED_SENT = -2;
+struct QueuedCommand {
+  Wire::CommandMessage msg;
+  int8_t client;   // gameClients index for directed delivery, or QUEUED_*
+};
+static QueuedCommand queuedCommands[OUTBOUND_COMMAND_QUEUE];
+static uint8_t queuedCommandCount = 0;
+
+// Outbound payload pool - publishers encode straight into a preallocated buffer
+static OutboundBuffer outboundPool[OUTBOUND_POOL_SIZE];
+
+OutboundBuffer* acquireOutbound() {
+  for (uint8_t i = 0; i < OUTBOUND_POOL_SIZE; i++) {
+    if (!outboundPool[i].inUse) {
+      outboundPool[i].inUse = true;
+      outboundPool[i].length = 0;
+      return &outboundPool[i];
+    }
+  }
+  logPrintf("Outbound pool exhausted (%d buffers)\n", OUTBOUND_POOL_SIZE);
+  return nullptr;
+}
+
+void releaseOutbound(OutboundBuffer* buffer) {
+  if (buffer) {
+    buffer->inUse = false;
+  }
+}
+
+// Serial.printf mallocs for lines of 64+ characters - format into a static
+// line buffer instead (loop task only)
+void logPrintf(const char* format, ...) {
+  static char line[LOG_LINE_MAX];
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
   
-  if (error) {
-    Serial.printf("JSON parse error: %s\n", error.c_str());
+  if (length < 0) return;
+  if (length >= (int)sizeof(line)) {
+    length = sizeof(line) - 1;
+  }
+  Serial.write((const uint8_t*)line, length);
+}
+
+// Interned client IDs - open addressing on an FNV-1a hash, entries hold the
+// gameClients index + 1 (0 = empty). Clients are never removed.
+static uint8_t clientIdTable[CLIENT_ID_TABLE_SIZE];
+
+static uint8_t hashClientId(const char* clientId) {
+  uint32_t hash = 2166136261u;
+  for (const char* c = clientId; *c; c++) {
+    hash = (hash ^ (uint8_t)*c) * 16777619u;
+  }
+  return hash & (CLIENT_ID_TABLE_SIZE - 1);
+}
+
+uint8_t lookupClient(const char* clientId) {
+  uint8_t bucket = hashClientId(clientId);
+  for (uint8_t probe = 0; probe < CLIENT_ID_TABLE_SIZE; probe++) {
+    uint8_t entry = clientIdTable[bucket];
+    if (entry == 0) break;
+    if (strcmp(gameClients[entry - 1].id, clientId) == 0) {
+      return entry - 1;
+    }
+    bucket = (bucket + 1) & (CLIENT_ID_TABLE_SIZE - 1);
+  }
+  return NO_CLIENT;
+}
+
+static void internClient(uint8_t index) {
+  uint8_t bucket = hashClientId(gameClients[index].id);
+  while (clientIdTable[bucket] != 0) {
+    bucket = (bucket + 1) & (CLIENT_ID_TABLE_SIZE - 1);
+  }
+  clientIdTable[bucket] = index + 1;
+}
+
+static ClientInfo* findClient(const char* clientId) {
+  uint8_t index = lookupClient(clientId);
+  return index != NO_CLIENT ? &gameClients[index] : nullptr;
+}
+
+// Directed topic (prefix + client ID) into out
+static const char* buildTopic(char* out, const char* prefix, const char* clientId) {
+  snprintf(out, WIRE_TOPIC_MAX, "%s%s", prefix, clientId);
+  return out;
+}
+
+// Directed topics are built once per client on join
+static void buildClientTopics(ClientInfo& client) {
+  buildTopic(client.assignTopic, Topic::ASSIGN, client.id);
+  buildTopic(client.ackTopic, Topic::ACK, client.id);
+  buildTopic(client.syncTopic, Topic::SYNC, client.id);
+  buildTopic(client.cmdTopic, Topic::CLIENT_CMD, client.id);
+}
+
+// Broadcast topics go out in binary only while every joined client speaks it
+Wire::Codec broadcastCodec() {
+  if (gameClientCount == 0) return Wire::Codec::JSON;
+  for (uint8_t i = 0; i < gameClientCount; i++) {
+    if (gameClients[i].codec != Wire::Codec::BINARY) {
+      return Wire::Codec::JSON;
+    }
+  }
+  return Wire::Codec::BINARY;
+}
+
+// Queue deltas are binary - only while every joined client applies them
+bool broadcastQueueDeltas() {
+  if (broadcastCodec() != Wire::Codec::BINARY) return false;
+  for (uint8_t i = 0; i < gameClientCount; i++) {
+    if (!gameClients[i].queueDeltas) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// MQTT Message Handlers
+void handleClientJoin(const uint8_t* payload, size_t length) {
+  Wire::JoinMessage msg;
+  if (!Wire::decode(payload, length, msg)) {
+    Serial.println("Join parse error");
     return;
   }
   
-  String clientId = doc[JsonKey::ID];
-  uint8_t capability = doc[JsonKey::CAPABILITY] | 8;  // default 8 if not provided
-  String firmware = doc[JsonKey::FIRMWARE] | "1.0";  // default if not provided
+  const char* clientId = msg.id;
+  Wire::Codec codec = Wire::firmwareSupportsBinary(msg.firmware) ? Wire::Codec::BINARY : Wire::Codec::JSON;
+  bool directCommands = Wire::firmwareAtLeast(msg.firmware, DIRECT_COMMAND_FIRMWARE);
+  bool batchCommands = Wire::firmwareAtLeast(msg.firmware, BATCH_FIRMWARE);
+  bool queueDeltas = Wire::firmwareAtLeast(msg.firmware, QUEUE_DELTA_FIRMWARE);
+  bool snapshots = Wire::firmwareAtLeast(msg.firmware, SNAPSHOT_FIRMWARE);
   
-  Serial.printf("Client join request: %s (cap: %d, fw: %s) - Phase: %s\n", 
-                clientId.c_str(), capability, firmware.c_str(), phaseToString(currentPhase));
+  logPrintf("Client join request: %s (cap: %d, fw: %s, codec: %s) - Phase: %s\n", 
+            clientId, msg.capability, msg.firmware,
+            codec == Wire::Codec::BINARY ? "binary" : "json", phaseToString(currentPhase));
   
   // ====== RECONNECT LOGIC - ALWAYS ALLOW KNOWN CLIENTS ======
   // Check if client already exists (reconnect scenario)
-  for (uint8_t i = 0; i < gameClientCount; i++) {
-    if (gameClients[i].id == clientId) {
-      gameClients[i].connected = true;
-      gameClients[i].lastSeen = millis();
-      Serial.printf("✓ Client %s RECONNECTED (slot %d)\n", clientId.c_str(), gameClients[i].slot);
-      
-      // Send assignment to restore client state
-      sendClientAssignment(clientId, gameClients[i].slot, gameClients[i].color);
-      
-      // Restore client state based on current game phase
-      StaticJsonDocument<200> stateDoc;
-      
-      // If client was in buzz queue, restore their state
-      bool wasInQueue = false;
-      for (uint8_t q = 0; q < queueLength; q++) {
-        if (buzzQueue[q] == clientId) {
-          wasInQueue = true;
-          Serial.printf("  → Client was in buzz queue at position %d\n", q);
-          
-          // If client is active, send ANIM_ACTIVE
-          if (activeClientIndex == q) {
-            stateDoc[JsonKey::CMD] = Command::ANIM_ACTIVE;
-            stateDoc[JsonKey::TARGET] = clientId;
-            String message;
-            serializeJson(stateDoc, message);
-            mqttBroker.publish(Topic::CMD, message.c_str());
-            Serial.printf("  → Restored ACTIVE state for %s\n", clientId.c_str());
-          } else {
-            // Client is waiting in queue, show white light
-            stateDoc[JsonKey::CMD] = Command::LIGHT_WHITE;
-            stateDoc[JsonKey::TARGET] = clientId;
-            String message;
-            serializeJson(stateDoc, message);
-            mqttBroker.publish(Topic::CMD, message.c_str());
-            Serial.printf("  → Restored LOCKED state for %s (waiting in queue)\n", clientId.c_str());
-          }
-          break;
-        }
-      }
+  uint8_t index = lookupClient(clientId);
+  if (index != NO_CLIENT) {
+    gameClients[index].connected = true;
+    gameClients[index].lastSeen = millis();
+    gameClients[index].clock.reset(); // client may have rebooted, its clock restarted
+    gameClients[index].lastBuzzSeq = 0;
+    bool codecChanged = gameClients[index].codec != codec; // reflashed in between
+    gameClients[index].codec = codec;
+    gameClients[index].directCommands = directCommands;
+    gameClients[index].batchCommands = batchCommands;
+    gameClients[index].queueDeltas = queueDeltas;
+    gameClients[index].snapshots = snapshots;
+    buildClientTopics(gameClients[index]);
+    logPrintf("✓ Client %s RECONNECTED (slot %d)\n", clientId, gameClients[index].slot);
+    
+    // Broadcast codec may have changed - refresh the retained state
+    if (codecChanged) {
+      gameManager->publishGameState();
+    }
+    
+    // Current firmware restores everything from one snapshot
+    if (snapshots) {
+      sendClientSnapshot(gameClients[index]);
+      return;
+    }
+    
+    // Send assignment to restore client state
+    sendClientAssignment(clientId, gameClients[index].slot, gameClients[index].color);
+    
+    // Restore client state based on current game phase
+    // If client was in buzz queue, restore their state
+    int8_t q = buzzQueue.find(index);
+    bool wasInQueue = q >= 0;
+    if (wasInQueue) {
+      logPrintf("  → Client was in buzz queue at position %d\n", q);
       
-      // If not in queue, restore IDLE state (if in READY/OPEN phase)
-      if (!wasInQueue && (currentPhase == Phase::READY || currentPhase == Phase::OPEN)) {
-        stateDoc[JsonKey::CMD] = Command::IDLE_COLOR;
-        stateDoc[JsonKey::TARGET] = clientId;
-        String message;
-        serializeJson(stateDoc, message);
-        mqttBroker.publish(Topic::CMD, message.c_str());
-        Serial.printf("  → Restored IDLE state for %s\n", clientId.c_str());
+      // If client is active, send ANIM_ACTIVE
+      if (activeClientIndex == q) {
+        publishCommand(makeCommand(CommandType::ANIM_ACTIVE, clientId));
+        logPrintf("  → Restored ACTIVE state for %s\n", clientId);
+      } else {
+        // Client is waiting in queue, show white light
+        publishCommand(makeCommand(CommandType::LIGHT_WHITE, clientId));
+        logPrintf("  → Restored LOCKED state for %s (waiting in queue)\n", clientId);
       }
-      
-      return; // Reconnect handled, exit function
     }
+    
+    // If not in queue, restore IDLE state (if in READY/OPEN phase)
+    if (!wasInQueue && (currentPhase == Phase::READY || currentPhase == Phase::OPEN)) {
+      publishCommand(makeCommand(CommandType::IDLE_COLOR, clientId));
+      logPrintf("  → Restored IDLE state for %s\n", clientId);
+    }
+    
+    return; // Reconnect handled, exit function
   }
   
   // ====== NEW CLIENT LOGIC - CHECK PHASE ======
   // Only allow new clients to join in LOBBY or READY phase
   if (currentPhase != Phase::LOBBY && currentPhase != Phase::READY) {
-    Serial.printf("✗ New client %s rejected - game in phase %s (only LOBBY/READY allowed)\n", 
-                  clientId.c_str(), phaseToString(currentPhase));
+    logPrintf("✗ New client %s rejected - game in phase %s (only LOBBY/READY allowed)\n", 
+              clientId, phaseToString(currentPhase));
     return;
   }
   
   // Check if game is locked (for new clients)
   if (gameLocked && currentPhase == Phase::READY) {
-    Serial.printf("✗ New client %s rejected - game locked in READY phase\n", clientId.c_str());
+    logPrintf("✗ New client %s rejected - game locked in READY phase\n", clientId);
     return;
   }
   
   // Add new client
   if (gameClientCount < MAX_CLIENTS) {
-    gameClients[gameClientCount].id = clientId;
+    strlcpy(gameClients[gameClientCount].id, clientId, sizeof(gameClients[gameClientCount].id));
     gameClients[gameClientCount].slot = gameClientCount + 1;
     gameClients[gameClientCount].color = PLAYER_COLORS[gameClientCount];
     gameClients[gameClientCount].connected = true;
-    gameClients[gameClientCount].buzzed = false;
+    buzzQueue.clearBuzzed(gameClientCount);
     gameClients[gameClientCount].lastSeen = millis();
+    gameClients[gameClientCount].clock.reset();
+    gameClients[gameClientCount].lastBuzzSeq = 0;
+    gameClients[gameClientCount].codec = codec;
+    gameClients[gameClientCount].directCommands = directCommands;
+    gameClients[gameClientCount].batchCommands = batchCommands;
+    gameClients[gameClientCount].queueDeltas = queueDeltas;
+    gameClients[gameClientCount].snapshots = snapshots;
+    buildClientTopics(gameClients[gameClientCount]);
+    internClient(gameClientCount);
     
-    Serial.printf("✓ New client added: %s (slot %d, color R:%d G:%d B:%d)\n",
-                  clientId.c_str(), gameClients[gameClientCount].slot,
-                  gameClients[gameClientCount].color.r, gameClients[gameClientCount].color.g, gameClients[gameClientCount].color.b);
+    logPrintf("✓ New client added: %s (slot %d, color R:%d G:%d B:%d)\n",
+              clientId, gameClients[gameClientCount].slot,
+              gameClients[gameClientCount].color.r, gameClients[gameClientCount].color.g, gameClients[gameClientCount].color.b);
     
-    sendClientAssignment(clientId, gameClients[gameClientCount].slot, gameClients[gameClientCount].color);
     gameClientCount++;
+    sendClientAssignment(clientId, gameClients[gameClientCount - 1].slot, gameClients[gameClientCount - 1].color);
     
     gameManager->publishGameState();
   } else {
-    Serial.printf("✗ Max clients reached, rejecting %s\n", clientId.c_str());
+    logPrintf("✗ Max clients reached, rejecting %s\n", clientId);
+  }
+}
+
+// Insert a buzz into the queue by compensated press time - the active client
+// keeps its turn, only waiting positions behind it are reordered
+static uint8_t insertIntoBuzzQueue(uint8_t client, uint32_t pressTime) {
+  uint8_t position = buzzQueue.size();
+  uint8_t firstWaiting = (activeClientIndex >= 0) ? activeClientIndex + 1 : 0;
+  for (uint8_t q = firstWaiting; q < buzzQueue.size(); q++) {
+    if ((int32_t)(pressTime - gameClients[buzzQueue.at(q)].buzzTime) < 0) {
+      position = q;
+      break;
+    }
   }
+  
+  buzzQueue.insert(position, client);
+  return position;
+}
+
+static void printBuzzQueue() {
+  Serial.print("Current buzz queue: ");
+  for (uint8_t i = 0; i < buzzQueue.size(); i++) {
+    logPrintf("[%d]%s ", i, gameClients[buzzQueue.at(i)].id);
+  }
+  Serial.println();
 }
 
-void handleClientBuzz(const String& payload) {
-  if (currentPhase != Phase::OPEN && currentPhase != Phase::ANSWER) {
-    Serial.printf("Buzz ignored - game phase is %s (need OPEN or ANSWER)\n", phaseToString(currentPhase));
+// Window length from the worst delivery jitter of connected clients
+static uint16_t computeBuzzWindow() {
+  uint32_t worstJitter = 0;
+  for (uint8_t i = 0; i < gameClientCount; i++) {
+    if (!gameClients[i].connected) continue;
+    if (!gameClients[i].clock.isSynced()) {
+      return BUZZ_WINDOW_MAX_MS; // can't judge this client yet - be safe
+    }
+    if (gameClients[i].clock.getJitter() > worstJitter) {
+      worstJitter = gameClients[i].clock.getJitter();
+    }
+  }
+  
+  uint32_t window = worstJitter * BUZZ_WINDOW_JITTER_FACTOR;
+  if (window < BUZZ_WINDOW_MIN_MS) window = BUZZ_WINDOW_MIN_MS;
+  if (window > BUZZ_WINDOW_MAX_MS) window = BUZZ_WINDOW_MAX_MS;
+  return window;
+}
+
+// Current 1-based position of a client's buzz (queue, or rank while held
+// in the arbitration window), 0 if not queued
+static uint8_t findBuzzPosition(uint8_t client) {
+  int8_t q = buzzQueue.find(client);
+  if (q >= 0) {
+    return q + 1;
+  }
+  for (uint8_t i = 0; i < pendingBuzzCount; i++) {
+    if (pendingBuzzes[i].client == client) {
+      uint8_t rank = 1;
+      for (uint8_t j = 0; j < pendingBuzzCount; j++) {
+        if (j != i && (int32_t)(pendingBuzzes[j].pressTime - pendingBuzzes[i].pressTime) < 0) {
+          rank++;
+        }
+      }
+      return rank;
+    }
+  }
+  return 0;
+}
+
+void handleClientBuzz(const uint8_t* payload, size_t length) {
+  Wire::BuzzMessage msg;
+  if (!Wire::decode(payload, length, msg)) {
+    Serial.println("Buzz parse error");
     return;
   }
   
-  StaticJsonDocument<200> doc;
-  DeserializationError error = deserializeJson(doc, payload);
+  const char* clientId = msg.id;
+  uint32_t now = inboundReceiveTime(); // arrival at the broker, not at the game task
+  bool hasClientTime = msg.hasTimestamp && !msg.hubTime;
+  uint32_t timestamp = hasClientTime ? msg.timestamp : now; // use current time if not provided
+  uint16_t seq = msg.seq;                                   // 0 = client without retransmit
   
-  if (error) {
-    Serial.printf("Buzz JSON parse error: %s\n", error.c_str());
+  if (currentPhase != Phase::ARMED && currentPhase != Phase::OPEN && currentPhase != Phase::ANSWER) {
+    logPrintf("Buzz ignored - game phase is %s (need ARMED, OPEN or ANSWER)\n", phaseToString(currentPhase));
+    sendBuzzAck(clientId, 0, now, timestamp, seq); // stop retransmits
     return;
   }
   
-  String clientId = doc[JsonKey::ID];
-  uint32_t timestamp = doc[JsonKey::TIMESTAMP] | millis(); // use current time if not provided
+  // Only joined clients take part - they have a slot, color and queue LED
+  uint8_t client = lookupClient(clientId);
+  if (client == NO_CLIENT) {
+    logPrintf("Buzz from unknown client %s ignored\n", clientId);
+    sendBuzzAck(clientId, 0, now, timestamp, seq); // stop retransmits
+    return;
+  }
   
-  // Check if client already buzzed
-  for (uint8_t i = 0; i < gameClientCount; i++) {
-    if (gameClients[i].id == clientId && gameClients[i].buzzed) {
-      Serial.printf("Client %s already buzzed, ignoring\n", clientId.c_str());
-      return;
-    }
+  // Retransmit of a buzz we already have - re-ack, ordering keeps the original press
+  if (seq > 0 && seq <= gameClients[client].lastBuzzSeq) {
+    sendBuzzAck(clientId, findBuzzPosition(client), now, timestamp, seq);
+    logPrintf("Duplicate buzz %s #%d, re-acked\n", clientId, seq);
+    return;
   }
   
-  // Add to buzz queue
-  if (queueLength < MAX_CLIENTS) {
-    buzzQueue[queueLength] = clientId;
-    queueLength++;
+  if (buzzQueue.hasBuzzed(client)) {
+    logPrintf("Client %s already buzzed, ignoring\n", clientId);
+    sendBuzzAck(clientId, findBuzzPosition(client), now, timestamp, seq);
+    return;
+  }
+  
+  if (seq > 0) {
+    gameClients[client].lastBuzzSeq = seq;
+  }
+  
+  // Convert press time to server clock - fall back to arrival time until synced
+  uint32_t pressTime = now;
+  bool offlineBuzz = msg.hasTimestamp && msg.hubTime;
+  if (offlineBuzz) {
+    // Buffered during a Wi-Fi drop, client already converted it to our clock
+    pressTime = msg.timestamp;
+  } else if (hasClientTime && gameClients[client].clock.isSynced()) {
+    pressTime = gameClients[client].clock.toLocal(timestamp);
+  }
+  
+  // A press can't happen after its arrival - clamp estimation error
+  if ((int32_t)(pressTime - now) > 0) {
+    pressTime = now;
+  }
+  
+  // Offline press from before this question was armed - belongs to an earlier
+  // question, not a false start in this one
+  if (offlineBuzz && (int32_t)(pressTime - questionArmTime) < 0) {
+    logPrintf("Stale offline buzz from %s (%d ms before question armed) ignored\n",
+              clientId, (int32_t)(questionArmTime - pressTime));
+    sendBuzzAck(clientId, 0, now, timestamp, seq); // stop retransmits
+    return;
+  }
+  
+  // Pressed before the announced open instant - flagged by the client itself,
+  // or clearly early by our clock estimate (hub time from offline buzzes is exact)
+  int32_t openDelta = (int32_t)(pressTime - questionOpenTime);
+  bool falseStart = msg.falseStart ||
+                    openDelta < (offlineBuzz ? 0 : -(int32_t)FALSE_START_TOLERANCE_MS);
+  if (falseStart) {
+    logPrintf("FALSE START from %s (%d ms before question opened)%s\n",
+              clientId, -openDelta, offlineBuzz ? " [offline]" : "");
+    sendBuzzAck(clientId, 0, now, timestamp, seq, true);
+    return;
+  }
+  
+  // No active player yet - hold the buzz in the arbitration window
+  if (activeClientIndex < 0) {
+    if (pendingBuzzCount >= MAX_CLIENTS) return;
     
-    // Mark client as buzzed
-    for (uint8_t i = 0; i < gameClientCount; i++) {
-      if (gameClients[i].id == clientId) {
-        gameClients[i].buzzed = true;
-        break;
+    // Ack first with the provisional rank among held buzzes
+    uint8_t rank = 1;
+    for (uint8_t i = 0; i < pendingBuzzCount; i++) {
+      if ((int32_t)(pendingBuzzes[i].pressTime - pressTime) <= 0) {
+        rank++;
       }
     }
+    sendBuzzAck(clientId, rank, now, timestamp, seq);
     
-    Serial.printf("BUZZ from %s (timestamp: %u), queue position: %d/%d\n", 
-                  clientId.c_str(), timestamp, queueLength, MAX_CLIENTS);
-    
-    // First buzz? Switch to ANSWER phase and send ANIM_ACTIVE
-    if (queueLength == 1) {
-      currentPhase = Phase::ANSWER;
-      activeClientIndex = 0;
-      Serial.printf("=== FIRST BUZZ! %s is now ACTIVE (index %d) ===\n", clientId.c_str(), activeClientIndex);
-      
-      // Send ANIM_ACTIVE command to first client
-      StaticJsonDocument<200> activeDoc;
-      activeDoc[JsonKey::CMD] = Command::ANIM_ACTIVE;
-      activeDoc[JsonKey::TARGET] = clientId;
-      
-      String activeMessage;
-      serializeJson(activeDoc, activeMessage);
-      mqttBroker.publish(Topic::CMD, activeMessage.c_str());
-      Serial.printf("Sent ANIM_ACTIVE to first client: %s\n", clientId.c_str());
-      
-      gameManager->publishGameState();
-    } else {
-      Serial.printf("Additional buzz: %s added to queue (position %d)\n", clientId.c_str(), queueLength);
+    if (pendingBuzzCount == 0) {
+      buzzWindowStart = now;
+      buzzWindowLength = computeBuzzWindow();
+      logPrintf("=== FIRST BUZZ - arbitration window open for %d ms ===\n", buzzWindowLength);
     }
     
-    // Debug: Print current queue
-    Serial.print("Current buzz queue: ");
-    for (uint8_t i = 0; i < queueLength; i++) {
-      Serial.printf("[%d]%s ", i, buzzQueue[i].c_str());
+    pendingBuzzes[pendingBuzzCount].client = client;
+    pendingBuzzes[pendingBuzzCount].pressTime = pressTime;
+    pendingBuzzCount++;
+    
+    buzzQueue.markBuzzed(client);
+    gameClients[client].buzzTime = pressTime;
+    
+    logPrintf("BUZZ from %s held (timestamp: %u, press: %u, arrival: %u, +%u ms into window)%s\n",
+              clientId, timestamp, pressTime, now, now - buzzWindowStart,
+              offlineBuzz ? " [offline]" : "");
+    
+    // Everyone who can still buzz has buzzed - no need to wait any longer
+    bool allBuzzed = true;
+    for (uint8_t i = 0; i < gameClientCount; i++) {
+      if (gameClients[i].connected && !buzzQueue.hasBuzzed(i)) {
+        allBuzzed = false;
+        break;
+      }
     }
-    Serial.println();
+    if (allBuzzed) {
+      closeBuzzWindow();
+    }
+    return;
+  }
+  
+  // Someone is already answering - queue behind them by press time
+  if (!buzzQueue.isFull()) {
+    uint8_t position = insertIntoBuzzQueue(client, pressTime);
+    sendBuzzAck(clientId, position + 1, now, timestamp, seq);
+    
+    buzzQueue.markBuzzed(client);
+    gameClients[client].buzzTime = pressTime;
+    
+    logPrintf("BUZZ from %s (timestamp: %u, press: %u, arrival: %u), queue position: %d/%d%s\n", 
+              clientId, timestamp, pressTime, now, position + 1, MAX_CLIENTS,
+              offlineBuzz ? " [offline]" : "");
+    printBuzzQueue();
     
-    gameManager->publishBuzzQueue();
+    gameManager->publishQueueDelta(Wire::QueueOp::PUSH, position);
     if (ledController) {
       ledController->updateServerLEDs();
     }
   }
 }
 
-void handleClientPing(const String& payload) {
-  StaticJsonDocument<100> doc;
-  DeserializationError error = deserializeJson(doc, payload);
+void closeBuzzWindow() {
+  if (pendingBuzzCount == 0) return;
+  
+  // Commit held buzzes sorted by press time - queue is empty, so sorted insert
+  // orders all of them
+  for (uint8_t i = 0; i < pendingBuzzCount && !buzzQueue.isFull(); i++) {
+    insertIntoBuzzQueue(pendingBuzzes[i].client, pendingBuzzes[i].pressTime);
+  }
+  logPrintf("Arbitration window closed after %u ms with %d buzz(es)\n",
+            (uint32_t)(millis() - buzzWindowStart), pendingBuzzCount);
+  cancelBuzzWindow();
+  
+  currentPhase = Phase::ANSWER;
+  activeClientIndex = 0;
+  const char* activeId = gameClients[buzzQueue.at(activeClientIndex)].id;
+  logPrintf("=== FIRST BUZZ! %s is now ACTIVE (index %d) ===\n", activeId, activeClientIndex);
+  
+  // Send ANIM_ACTIVE command to first client
+  publishCommand(makeCommand(CommandType::ANIM_ACTIVE, activeId));
+  logPrintf("Sent ANIM_ACTIVE to first client: %s\n", activeId);
+  
+  gameManager->publishGameState();
+  printBuzzQueue();
+  
+  gameManager->publishBuzzQueue();
+  if (ledController) {
+    ledController->updateServerLEDs();
+  }
+}
+
+void processBuzzWindow() {
+  if (pendingBuzzCount > 0 && millis() - buzzWindowStart >= buzzWindowLength) {
+    closeBuzzWindow();
+  }
+}
+
+uint32_t msUntilBuzzWindowCloses() {
+  if (pendingBuzzCount == 0) return UINT32_MAX;
+  uint32_t elapsed = millis() - buzzWindowStart;
+  return elapsed < buzzWindowLength ? buzzWindowLength - elapsed : 0;
+}
+
+void cancelBuzzWindow() {
+  pendingBuzzCount = 0;
+}
+
+void handleClientPing(const uint8_t* payload, size_t length) {
+  Wire::PingMessage msg;
+  if (!Wire::decode(payload, length, msg)) return;
   
-  if (error) return;
+  const char* clientId = msg.id;
+  uint32_t now = inboundReceiveTime();
   
-  String clientId = doc[JsonKey::ID];
+  uint8_t client = lookupClient(clientId);
+  if (client == NO_CLIENT) return;
   
   // Update last seen timestamp
-  for (uint8_t i = 0; i < gameClientCount; i++) {
-    if (gameClients[i].id == clientId) {
-      gameClients[i].lastSeen = millis();
-      break;
+  gameClients[client].lastSeen = now;
+  if (!msg.hasTimestamp) return;
+  uint32_t clientTime = msg.timestamp;
+  
+  // Answer to our PING_REQUEST - use round-trip as clock sync sample
+  if (msg.hasEcho) {
+    uint32_t serverSent = msg.echo;
+    if (gameClients[client].clock.addSample(serverSent, clientTime, now)) {
+      logPrintf("Clock sync %s: offset %d ms, rtt %u ms\n", clientId,
+                gameClients[client].clock.getOffset(), gameClients[client].clock.getRtt());
     }
   }
+  
+  // Let the client sample the hub clock from the same exchange
+  sendClockSync(clientId, clientTime, now);
 }
 
 // MQTT Publishers
-void sendClientAssignment(const String& clientId, uint8_t slot, const Rgb& color) {
-  StaticJsonDocument<200> doc;
-  doc[JsonKey::SLOT] = slot;
-  char colorHex[8];
-  sprintf(colorHex, "#%02X%02X%02X", color.r, color.g, color.b);
-  doc[JsonKey::COLOR] = colorHex;
+void sendClientAssignment(const char* clientId, uint8_t slot, const Rgb& color) {
+  Wire::AssignMessage msg;
+  msg.slot = slot;
+  msg.color = color;
   
-  String message;
-  serializeJson(doc, message);
+  // Binary assignment also confirms the codec to the client
+  ClientInfo* client = findClient(clientId);
+  char topic[WIRE_TOPIC_MAX];
+  publishMessage(client ? client->assignTopic : buildTopic(topic, Topic::ASSIGN, clientId), msg,
+                 client ? client->codec : Wire::Codec::JSON, true); // retained
   
-  String topic = String(Topic::ASSIGN) + clientId;
-  mqttBroker.publish(topic.c_str(), message.c_str(), true); // retained
+  logPrintf("Sent assignment to %s: slot %d, color #%02X%02X%02X\n", 
+            clientId, slot, color.r, color.g, color.b);
+}
+
+// Reconnect snapshot - assignment, phase and queue standing in one directed
+// message. Not retained: it is only valid for this join.
+void sendClientSnapshot(const ClientInfo& client) {
+  Wire::SnapshotMessage msg;
+  msg.slot = client.slot;
+  msg.color = client.color;
+  msg.phase = currentPhase;
+  msg.locked = gameLocked;
+  msg.hasOpenAt = (currentPhase == Phase::ARMED || currentPhase == Phase::OPEN || currentPhase == Phase::ANSWER);
+  msg.openAt = questionOpenTime;
+  msg.position = 0;
+  msg.active = false;
+  int8_t q = buzzQueue.find((uint8_t)(&client - gameClients));
+  if (q >= 0) {
+    msg.position = q + 1;
+    msg.active = activeClientIndex == q;
+  }
+  msg.epoch = gameManager->stateEpoch();
+  msg.seq = gameManager->stateSequence();
+  
+  OutboundBuffer* buffer = acquireOutbound();
+  if (!buffer) return;
+  buffer->length = Wire::encode(msg, buffer->data, sizeof(buffer->data));
+  if (buffer->length > 0) {
+    postOutbound(client.assignTopic, buffer->data, buffer->length, false);
+  }
+  logPrintf("Sent snapshot to %s: slot %d, %s, queue position %d%s (%u bytes)\n", client.id, msg.slot,
+            phaseToString(msg.phase), msg.position, msg.active ? " active" : "", (unsigned)buffer->length);
+  releaseOutbound(buffer);
+}
+
+// Directed reply to a client ping - client time echoed with server time
+void sendClockSync(const char* clientId, uint32_t clientTime, uint32_t serverTime) {
+  Wire::SyncMessage msg;
+  msg.echo = clientTime;
+  msg.serverTime = serverTime;
+  
+  ClientInfo* client = findClient(clientId);
+  char topic[WIRE_TOPIC_MAX];
+  publishMessage(client ? client->syncTopic : buildTopic(topic, Topic::SYNC, clientId), msg,
+                 client ? client->codec : Wire::Codec::JSON);
+}
+
+// Directed ack right after a buzz is accepted, before any broadcast -
+// carries queue position (1-based, 0 = not queued) and server receive time
+void sendBuzzAck(const char* clientId, uint8_t position, uint32_t receiveTime, uint32_t pressTime, uint16_t seq,
+                 bool falseStart) {
+  Wire::AckMessage msg;
+  msg.position = position;
+  msg.receiveTime = receiveTime;
+  msg.pressTime = pressTime;
+  msg.seq = seq;
+  msg.falseStart = falseStart;
+  
+  ClientInfo* client = findClient(clientId);
+  char topic[WIRE_TOPIC_MAX];
+  publishMessage(client ? client->ackTopic : buildTopic(topic, Topic::ACK, clientId), msg,
+                 client ? client->codec : Wire::Codec::JSON);
+}
+
+Wire::CommandMessage makeCommand(CommandType cmd, const char* target) {
+  Wire::CommandMessage msg;
+  msg.cmd = cmd;
+  strlcpy(msg.target, target, sizeof(msg.target));
+  msg.hasStart = false;
+  msg.start = 0;
+  msg.hasTimestamp = false;
+  msg.timestamp = 0;
+  return msg;
+}
+
+static uint8_t connectedClientCount() {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < gameClientCount; i++) {
+    if (gameClients[i].connected) count++;
+  }
+  return count;
+}
+
+// QoS 0 PUBLISH as delivered to one subscriber: fixed header, topic length,
+// topic, payload
+static uint32_t publishAirBytes(const char* topic, size_t payloadLength) {
+  return 2 + 2 + strlen(topic) + payloadLength;
+}
+
+// Directed commands go to the target's own topic when its firmware listens
+// there, everything else to the broadcast topic every client parses. Held
+// until the end of the loop tick so one tick costs one frame per recipient.
+void publishCommand(const Wire::CommandMessage& msg) {
+  if (queuedCommandCount == OUTBOUND_COMMAND_QUEUE) {
+    flushCommands();
+  }
+  
+  ClientInfo* client = msg.target[0] != '\0' ? findClient(msg.target) : nullptr;
+  QueuedCommand& queued = queuedCommands[queuedCommandCount++];
+  queued.msg = msg;
+  queued.client = (client && client->directCommands) ? (int8_t)(client - gameClients) : QUEUED_BROADCAST;
+}
+
+static void sendCommandFrame(const char* topic, const uint8_t* data, size_t length, bool direct) {
+  if (!postOutbound(topic, data, length, false)) return;
+  airStats.frames++;
+  airStats.bytes += publishAirBytes(topic, length) * (direct ? 1 : connectedClientCount());
+}
+
+// A batch of one goes out as the plain frame
+static void sendCommandBatch(const char* topic, const OutboundBuffer* batch, uint8_t count) {
+  if (count == 0) return;
+  if (count == 1) {
+    size_t offset = 0;
+    const uint8_t* frame;
+    size_t frameLength;
+    if (Wire::nextBatchFrame(batch->data, batch->length, offset, frame, frameLength)) {
+      sendCommandFrame(topic, frame, frameLength, true);
+    }
+    return;
+  }
+  sendCommandFrame(topic, batch->data, batch->length, true);
+}
+
+// Send the queued commands in order - a client that unpacks batches gets all
+// of its commands in one frame, everything else goes out one publish each
+void flushCommands() {
+  if (queuedCommandCount == 0) return;
+  
+  OutboundBuffer* frame = acquireOutbound();
+  OutboundBuffer* batch = acquireOutbound();
+  if (frame && batch) {
+    uint8_t listeners = connectedClientCount();
+    for (uint8_t i = 0; i < queuedCommandCount; i++) {
+      int8_t target = queuedCommands[i].client;
+      if (target == QUEUED_SENT) continue;
+      
+      ClientInfo* client = target >= 0 ? &gameClients[target] : nullptr;
+      const char* topic = client ? client->cmdTopic : Topic::CMD;
+      Wire::Codec codec = client ? client->codec : broadcastCodec();
+      bool batching = client && client->batchCommands && codec == Wire::Codec::BINARY;
+      uint8_t batched = 0;
+      batch->length = Wire::beginBatch(batch->data, sizeof(batch->data));
+      
+      for (uint8_t j = i; j < queuedCommandCount; j++) {
+        if (queuedCommands[j].client != target) continue;
+        queuedCommands[j].client = QUEUED_SENT;
+        
+        frame->length = Wire::encode(queuedCommands[j].msg, codec, frame->data, sizeof(frame->data));
+        if (frame->length == 0) continue;
+        airStats.broadcastBytes += publishAirBytes(Topic::CMD, frame->length) * listeners;
+        
+        if (!batching) {
+          sendCommandFrame(topic, frame->data, frame->length, client != nullptr);
+          break;
+        }
+        
+        size_t appended = Wire::appendToBatch(batch->data, batch->length, sizeof(batch->data),
+                                              frame->data, frame->length);
+        if (appended == 0) {
+          // Batch full - send it and start the next one with this frame
+          sendCommandBatch(topic, batch, batched);
+          batched = 0;
+          batch->length = Wire::beginBatch(batch->data, sizeof(batch->data));
+          appended = Wire::appendToBatch(batch->data, batch->length, sizeof(batch->data),
+                                         frame->data, frame->length);
+          if (appended == 0) {
+            sendCommandFrame(topic, frame->data, frame->length, true);
+            continue;
+          }
+        }
+        batch->length = appended;
+        batched++;
+      }
+      sendCommandBatch(topic, batch, batched);
+    }
+  }
   
-  Serial.printf("Sent assignment to %s: slot %d, color %s\n", 
-                clientId.c_str(), slot, colorHex);
+  releaseOutbound(frame);
+  releaseOutbound(batch);
+  queuedCommandCount = 0;
+}
+
+// End of a loop tick - send everything the tick raised
+void flushOutbound() {
+  flushCommands();
+  if (gameManager) {
+    gameManager->flushPublishes();
+  }
+}
+
+void resetAirStats() {
+  airStats.frames = 0;
+  airStats.bytes = 0;
+  airStats.broadcastBytes = 0;
+}
+
+void logAirStats() {
+  logPrintf("Round commands: %u frames, %u bytes on air (%u if broadcast)\n",
+            airStats.frames, airStats.bytes, airStats.broadcastBytes);
 }
 
 // Functions moved to GameManager class
 
 void publishAnnounce() {
-  StaticJsonDocument<200> doc;
-  doc[JsonKey::VERSION] = PROTOCOL_VERSION;
-  doc[JsonKey::MAX_CLIENTS] = MAX_CLIENTS;
-  doc[JsonKey::LOCKED] = gameLocked;
+  Wire::AnnounceMessage msg;
+  msg.maxClients = MAX_CLIENTS;
+  msg.locked = gameLocked;
   
-  String message;
-  serializeJson(doc, message);
+  OutboundBuffer* buffer = acquireOutbound();
+  if (!buffer) return;
+  buffer->length = Wire::encode(msg, buffer->data, sizeof(buffer->data));
   
-  mqttBroker.publish(Topic::ANNOUNCE, message.c_str(), true); // retained
-  Serial.printf("Published announce: %s\n", message.c_str());
+  postOutbound(Topic::ANNOUNCE, buffer->data, buffer->length, true); // retained
+  logPrintf("Published announce: %.*s\n", (int)buffer->length, (const char*)buffer->data);
+  releaseOutbound(buffer);
 }
 
 void checkClientTimeouts() {
@@ -266,8 +804,8 @@ void checkClientTimeouts() {
   for (uint8_t i = 0; i < gameClientCount; i++) {
     if (gameClients[i].connected && (now - gameClients[i].lastSeen > CLIENT_TIMEOUT_MS)) {
       gameClients[i].connected = false;
-      Serial.printf("⚠ Client %s timed out (no ping for %d ms)\n", 
-                    gameClients[i].id.c_str(), CLIENT_TIMEOUT_MS);
+      logPrintf("⚠ Client %s timed out (no ping for %d ms)\n", 
+                gameClients[i].id, CLIENT_TIMEOUT_MS);
       
       // Note: Client stays in gameClients array and can reconnect at any time
       // Their slot and color are preserved for seamless reconnection
@@ -0,0 +1,157 @@
+#include "network_task.h"
+#include "mqtt_server.h"
+#include "event_loop.h"
+#include "spsc_queue.h"
+#include <atomic>
+
+// Received message, read straight into its queue slot by the broker callback
+struct InboundMessage {
+  TopicId topic;
+  uint32_t receivedAt;
+  uint16_t length;
+  uint8_t payload[WIRE_FRAME_MAX];
+};
+
+// Publish waiting for the broker
+struct OutboundFrame {
+  char topic[WIRE_TOPIC_MAX];
+  bool retain;
+  uint16_t length;
+  uint8_t data[WIRE_FRAME_MAX];
+};
+
+static SpscQueue<InboundMessage, INBOUND_QUEUE_SIZE> inboundQueue;
+static SpscQueue<OutboundFrame, OUTBOUND_FRAME_QUEUE> outboundQueue;
+
+static TaskHandle_t networkTask = nullptr;
+static std::atomic<uint16_t> pollMs(EVENT_POLL_IDLE_MS);
+static uint32_t currentReceiveTime = 0;
+
+// Written by the network task, read and reset (via the flag) by the loop task
+struct NetworkStats {
+  uint32_t loops;
+  uint32_t maxGapUs;        // longest time between two broker loops
+  uint32_t inboundDropped;
+};
+static volatile NetworkStats networkStats = {};
+static std::atomic<bool> statsResetRequested(false);
+
+// Loop task only - postOutbound() counts, logNetworkStats() reads and resets
+static uint32_t outboundDropped = 0;
+
+// Broker callback (network task) - oversized payloads and a full queue drop
+// the message
+static void receiveMessage(const char* topic, Stream& stream) {
+  InboundMessage* message = inboundQueue.slotToFill();
+  size_t length = 0;
+  bool overflow = message == nullptr;
+  while (stream.available() > 0) {
+    int value = stream.read();
+    if (value < 0) break;
+    if (!overflow && length < sizeof(message->payload)) {
+      message->payload[length++] = value;
+    } else {
+      overflow = true;
+    }
+  }
+  if (overflow) {
+    networkStats.inboundDropped++;
+    return;
+  }
+  
+  message->topic = topicToId(topic);
+  message->receivedAt = millis();
+  message->length = length;
+  inboundQueue.push();
+  eventLoop.wake();
+}
+
+// Hand queued publishes to the broker, in order
+static void drainOutbound() {
+  OutboundFrame* frame;
+  while ((frame = outboundQueue.front()) != nullptr) {
+    mqttBroker.publish(frame->topic, frame->data, frame->length, 0, frame->retain);
+    outboundQueue.pop();
+  }
+}
+
+static void networkLoop(void*) {
+  uint32_t lastLoop = micros();
+  while (true) {
+    uint32_t now = micros();
+    if (statsResetRequested.exchange(false)) {
+      networkStats.loops = 0;
+      networkStats.maxGapUs = 0;
+      networkStats.inboundDropped = 0;
+    }
+    networkStats.loops++;
+    if (now - lastLoop > networkStats.maxGapUs) {
+      networkStats.maxGapUs = now - lastLoop;
+    }
+    lastLoop = now;
+    
+    mqttBroker.loop();
+    drainOutbound();
+    
+    // Sockets have no data-ready callback - poll, or go early for outbound
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(pollMs.load()));
+  }
+}
+
+void startNetworkTask(const MessageHandler* handlers) {
+  for (uint8_t id = 0; id < TOPIC_COUNT; id++) {
+    if (handlers[id]) {
+      mqttBroker.subscribe(TOPIC_ROUTES[id].name, receiveMessage);
+    }
+  }
+  mqttBroker.begin();
+  
+  xTaskCreatePinnedToCore(networkLoop, "network", NETWORK_TASK_STACK, nullptr, NETWORK_TASK_PRIORITY,
+                          &networkTask, NETWORK_TASK_CORE);
+}
+
+void processInbound(const MessageHandler* handlers) {
+  InboundMessage* message;
+  while ((message = inboundQueue.front()) != nullptr) {
+    MessageHandler handler = handlers[(uint8_t)message->topic];
+    if (handler) {
+      currentReceiveTime = message->receivedAt;
+      handler(message->payload, message->length);
+    }
+    inboundQueue.pop();
+  }
+}
+
+uint32_t inboundReceiveTime() {
+  return currentReceiveTime;
+}
+
+bool postOutbound(const char* topic, const uint8_t* data, size_t length, bool retain) {
+  OutboundFrame* frame = outboundQueue.slotToFill();
+  if (!frame || length > sizeof(frame->data)) {
+    outboundDropped++;
+    return false;
+  }
+  
+  strlcpy(frame->topic, topic, sizeof(frame->topic));
+  frame->retain = retain;
+  frame->length = length;
+  memcpy(frame->data, data, length);
+  outboundQueue.push();
+  
+  if (networkTask) {
+    xTaskNotifyGive(networkTask);
+  }
+  return true;
+}
+
+void setNetworkPollInterval(uint16_t ms) {
+  pollMs.store(ms);
+}
+
+void logNetworkStats() {
+  logPrintf("Network: %u broker loops, max gap %u us, dropped %u in / %u out\n", networkStats.loops,
+            networkStats.maxGapUs, networkStats.inboundDropped, outboundDropped);
+  outboundDropped = 0;
+  statsResetRequested.store(true);
+}
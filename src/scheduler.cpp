@@ -0,0 +1,104 @@
+#include "scheduler.h"
+
+Scheduler scheduler;
+
+// millis() wraps - due times compare by signed distance
+static bool dueBefore(uint32_t a, uint32_t b) {
+  return (int32_t)(a - b) < 0;
+}
+
+Scheduler::Scheduler() : count(0) {
+}
+
+void Scheduler::siftUp(uint8_t index) {
+  while (index > 0) {
+    uint8_t parent = (index - 1) / 2;
+    if (!dueBefore(heap[index].due, heap[parent].due)) break;
+    Entry swap = heap[parent];
+    heap[parent] = heap[index];
+    heap[index] = swap;
+    index = parent;
+  }
+}
+
+void Scheduler::siftDown(uint8_t index) {
+  while (true) {
+    uint8_t earliest = index;
+    uint8_t left = 2 * index + 1;
+    uint8_t right = left + 1;
+    if (left < count && dueBefore(heap[left].due, heap[earliest].due)) earliest = left;
+    if (right < count && dueBefore(heap[right].due, heap[earliest].due)) earliest = right;
+    if (earliest == index) break;
+    Entry swap = heap[earliest];
+    heap[earliest] = heap[index];
+    heap[index] = swap;
+    index = earliest;
+  }
+}
+
+void Scheduler::removeAt(uint8_t index) {
+  count--;
+  if (index == count) return;
+  heap[index] = heap[count];
+  siftDown(index);
+  siftUp(index);
+}
+
+bool Scheduler::at(uint32_t due, DeferredAction action, uint8_t arg) {
+  if (count >= SCHEDULER_CAPACITY) {
+    Serial.println("Scheduler full - deferred action dropped");
+    return false;
+  }
+  heap[count].due = due;
+  heap[count].action = action;
+  heap[count].arg = arg;
+  siftUp(count);
+  count++;
+  return true;
+}
+
+bool Scheduler::after(uint32_t delayMs, DeferredAction action, uint8_t arg) {
+  return at(millis() + delayMs, action, arg);
+}
+
+void Scheduler::cancel(DeferredAction action) {
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    if (heap[i].action != action) {
+      heap[kept++] = heap[i];
+    }
+  }
+  if (kept == count) return;
+  count = kept;
+  for (uint8_t i = count / 2; i-- > 0;) {
+    siftDown(i);
+  }
+}
+
+bool Scheduler::isPending(DeferredAction action) const {
+  for (uint8_t i = 0; i < count; i++) {
+    if (heap[i].action == action) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint8_t Scheduler::size() const {
+  return count;
+}
+
+uint32_t Scheduler::msUntilNext() const {
+  if (count == 0) return UINT32_MAX;
+  int32_t remaining = (int32_t)(heap[0].due - millis());
+  return remaining > 0 ? remaining : 0;
+}
+
+void Scheduler::run() {
+  // Popped before the call - an action may schedule or cancel others
+  while (count > 0 && !dueBefore(millis(), heap[0].due)) {
+    Entry entry = heap[0];
+    removeAt(0);
+    entry.action(entry.arg);
+  }
+}
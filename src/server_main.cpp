@@ -2,22 +2,36 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <Adafruit_NeoPixel.h>
-#include <Bounce2.h>
 #include "config.h"
 #include "protocol.h"
 #include "mqtt_server.h"
 #include "led_controller.h"
 #include "game_manager.h"
+#include "scheduler.h"
+#include "event_loop.h"
+#include "network_task.h"
+#include "button_input.h"
 
 // Hardware Objects
 Adafruit_NeoPixel strip(LED_COUNT, LED_PIN, NEO_GRB + NEO_KHZ800);
-Bounce button = Bounce();
+
+// Inbound dispatch, indexed by TopicId - topics the server only publishes
+// have no handler and are never subscribed. Handlers run in the loop task,
+// fed by the network task's inbound queue.
+static MessageHandler serverHandlers[TOPIC_COUNT + 1];
+
+static void pingClients() {
+  if (gameManager) gameManager->sendPingToAllClients();
+}
 
 void setup() {
   Serial.begin(115200);
   Serial.println("ESP32 Quiz-Buzzer Server Starting...");
-  Serial.printf("Hardware Config - LED Pin: %d, Button Pin: %d, LED Count: %d\n", 
-                LED_PIN, BUTTON_PIN, LED_COUNT);
+  Serial.printf("Hardware Config - LED Pin: %d, Button Pins: %d/%d/%d, LED Count: %d\n", 
+                LED_PIN, BUTTON_PIN, NEXT_BUTTON_PIN, CORRECT_BUTTON_PIN, LED_COUNT);
+  
+  // Loop task sleeps between events from here on
+  eventLoop.begin();
   
   // Initialize LEDs
   strip.begin();
@@ -28,13 +42,9 @@ void setup() {
   // Initialize LED Controller
   ledController = new LEDController(strip);
   
-  // Initialize Button
-  pinMode(BUTTON_PIN, INPUT_PULLUP);
-  button.attach(BUTTON_PIN);
-  button.interval(DEBOUNCE_MS);
-  
-  // Initialize Button Handler
-  buttonHandler = new ButtonHandler(button);
+  // Initialize Buttons - main, NEXT and CORRECT, edge interrupts wake the loop
+  buttonInput = new ButtonInput();
+  buttonInput->begin();
   
   // Initialize Game Manager
   gameManager = new GameManager();
@@ -51,22 +61,15 @@ void setup() {
   // Initialize MQTT Broker
   Serial.println("Starting PicoMQTT Broker...");
   
-  // Setup MQTT message handlers
-  mqttBroker.subscribe(Topic::JOIN, [](const char * payload) {
-    handleClientJoin(String(payload));
-  });
-  
-  mqttBroker.subscribe(Topic::BUZZ, [](const char * payload) {
-    handleClientBuzz(String(payload));
-  });
+  // Setup MQTT message handlers - payloads JSON or binary
+  serverHandlers[(uint8_t)TopicId::JOIN] = handleClientJoin;
+  serverHandlers[(uint8_t)TopicId::BUZZ] = handleClientBuzz;
+  serverHandlers[(uint8_t)TopicId::PING] = handleClientPing;
   
-  mqttBroker.subscribe(Topic::PING, [](const char * payload) {
-    handleClientPing(String(payload));
-  });
+  // Broker gets its own task and core from here on
+  startNetworkTask(serverHandlers);
   
-  mqttBroker.begin();
-  
-  Serial.printf("MQTT Broker running on port %d\n", MQTT_PORT);
+  Serial.printf("MQTT Broker running on port %d (core %d)\n", MQTT_PORT, NETWORK_TASK_CORE);
   
   // Publish initial announcements
   publishAnnounce();
@@ -77,37 +80,60 @@ void setup() {
   ledController->showRGBTest();
   
   Serial.println("=== PHASE: BOOT ===");
+  gameManager->begin();
+  eventLoop.addTimer("ping", PING_INTERVAL_MS, pingClients); // Background ping system
+  eventLoop.addTimer("timeouts", CLIENT_CHECK_INTERVAL_MS, checkClientTimeouts);
+  eventLoop.addTimer("network", EVENT_STATS_INTERVAL_MS, logNetworkStats);
   Serial.println("Phase Controls:");
   Serial.println("- SHORT press: LOBBY -> READY -> OPEN -> NEXT");
   Serial.println("- LONG press: Correct Answer / Reset");
   Serial.println("- VERY LONG press: Unlock game");
+  Serial.println("- NEXT button: Wrong answer, next client");
+  Serial.println("- CORRECT button: Correct answer / Next phase");
   Serial.println("Server ready for client connections!");
 }
 
+// Game task - Arduino loop task, core 1
 void loop() {
-  // Handle MQTT broker
-  mqttBroker.loop();
-  
-  // Handle button presses
-  if (buttonHandler) {
-    ButtonPress press = buttonHandler->checkButtonPress();
-    if (press != ButtonPress::NONE && gameManager) {
-      gameManager->handleButtonPress(press);
+  // Messages the network task received
+  processInbound(serverHandlers);
+  
+  // Commit held buzzes once the arbitration window has elapsed
+  processBuzzWindow();
+  
+  // Deferred actions that came due (delayed commands, phase timeouts)
+  scheduler.run();
+  
+  // Handle button events
+  if (buttonInput) {
+    buttonInput->update();
+    ButtonEvent event;
+    while (buttonInput->nextEvent(event)) {
+      if (gameManager) {
+        gameManager->handleButtonEvent(event);
+      }
     }
   }
   
   // Handle game phases
   if (gameManager) {
     gameManager->handlePhase();
-    gameManager->sendPingToAllClients(); // Background ping system
   }
   
-  // Check for client timeouts (every 5 seconds)
-  static uint32_t lastClientCheck = 0;
-  if (millis() - lastClientCheck > 5000) {
-    checkClientTimeouts();
-    lastClientCheck = millis();
-  }
+  // LED frames, pings, client timeout checks
+  eventLoop.run();
+  
+  // One combined send for everything this tick changed
+  flushOutbound();
   
-  delay(10); // Small delay for stability
+  // Sleep until a message or button edge, the next timer, deferred action,
+  // buzz window close or button hold threshold
+  uint32_t limit = scheduler.msUntilNext();
+  if (msUntilBuzzWindowCloses() < limit) {
+    limit = msUntilBuzzWindowCloses();
+  }
+  if (buttonInput && buttonInput->msUntilDue() < limit) {
+    limit = buttonInput->msUntilDue();
+  }
+  eventLoop.wait(limit);
 }
\ No newline at end of file
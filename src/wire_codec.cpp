@@ -0,0 +1,647 @@
+#include "wire_codec.h"
+#include <ArduinoJson.h>
+
+namespace Wire {
+
+// Binary writer - stops writing once the buffer is full, ok() tells
+class BinaryWriter {
+private:
+  uint8_t* out;
+  size_t capacity;
+  size_t pos;
+
+public:
+  BinaryWriter(uint8_t* buffer, size_t size, MessageType type) : out(buffer), capacity(size), pos(0) {
+    u8(WIRE_BINARY_MAGIC);
+    u8((uint8_t)type);
+  }
+
+  void u8(uint8_t value) {
+    if (pos < capacity) out[pos] = value;
+    pos++;
+  }
+
+  void u16(uint16_t value) {
+    u8(value & 0xFF);
+    u8(value >> 8);
+  }
+
+  void u32(uint32_t value) {
+    u16(value & 0xFFFF);
+    u16(value >> 16);
+  }
+
+  void str(const char* value) {
+    size_t length = strnlen(value, WIRE_ID_MAX);
+    u8(length);
+    for (size_t i = 0; i < length; i++) {
+      u8(value[i]);
+    }
+  }
+
+  size_t finish() const {
+    return pos <= capacity ? pos : 0;
+  }
+};
+
+// Binary reader - bounds checked, ok() turns false on any overrun
+class BinaryReader {
+private:
+  const uint8_t* in;
+  size_t length;
+  size_t pos;
+  bool valid;
+
+public:
+  BinaryReader(const uint8_t* payload, size_t size, MessageType type) : in(payload), length(size), pos(2),
+                                                                        valid(isBinary(payload, size) &&
+                                                                              payload[1] == (uint8_t)type) {}
+
+  uint8_t u8() {
+    if (pos >= length) {
+      valid = false;
+      return 0;
+    }
+    return in[pos++];
+  }
+
+  uint16_t u16() {
+    uint16_t low = u8();
+    return low | ((uint16_t)u8() << 8);
+  }
+
+  uint32_t u32() {
+    uint32_t low = u16();
+    return low | ((uint32_t)u16() << 16);
+  }
+
+  void str(char* out, size_t size) {
+    size_t count = u8();
+    if (count >= size || pos + count > length) {
+      valid = false;
+      out[0] = '\0';
+      return;
+    }
+    memcpy(out, in + pos, count);
+    out[count] = '\0';
+    pos += count;
+  }
+
+  bool atEnd() const {
+    return pos >= length;
+  }
+
+  bool ok() const {
+    return valid;
+  }
+};
+
+static size_t finishJson(const JsonDocument& doc, uint8_t* out, size_t capacity) {
+  if (measureJson(doc) >= capacity) {
+    return 0;
+  }
+  return serializeJson(doc, (char*)out, capacity);
+}
+
+bool firmwareAtLeast(const char* firmware, const char* minimum) {
+  // Compare "major.minor" numerically
+  char* rest;
+  long major = strtol(firmware, &rest, 10);
+  long minor = (*rest == '.') ? strtol(rest + 1, NULL, 10) : 0;
+  long minMajor = strtol(minimum, &rest, 10);
+  long minMinor = (*rest == '.') ? strtol(rest + 1, NULL, 10) : 0;
+  return major > minMajor || (major == minMajor && minor >= minMinor);
+}
+
+bool firmwareSupportsBinary(const char* firmware) {
+  return firmwareAtLeast(firmware, BINARY_CODEC_FIRMWARE);
+}
+
+// Join
+size_t encode(const JoinMessage& msg, uint8_t* out, size_t capacity) {
+  StaticJsonDocument<200> doc;
+  doc[JsonKey::ID] = msg.id;
+  doc[JsonKey::CAPABILITY] = msg.capability;
+  doc[JsonKey::FIRMWARE] = msg.firmware;
+  return finishJson(doc, out, capacity);
+}
+
+bool decode(const uint8_t* payload, size_t length, JoinMessage& msg) {
+  StaticJsonDocument<200> doc;
+  if (deserializeJson(doc, payload, length)) return false;
+
+  strlcpy(msg.id, doc[JsonKey::ID] | "", sizeof(msg.id));
+  msg.capability = doc[JsonKey::CAPABILITY] | 8;          // default 8 if not provided
+  strlcpy(msg.firmware, doc[JsonKey::FIRMWARE] | "1.0", sizeof(msg.firmware));
+  return true;
+}
+
+// Announce
+size_t encode(const AnnounceMessage& msg, uint8_t* out, size_t capacity) {
+  StaticJsonDocument<200> doc;
+  doc[JsonKey::VERSION] = PROTOCOL_VERSION;
+  doc[JsonKey::MAX_CLIENTS] = msg.maxClients;
+  doc[JsonKey::LOCKED] = msg.locked;
+  return finishJson(doc, out, capacity);
+}
+
+// Assign
+size_t encode(const AssignMessage& msg, Codec codec, uint8_t* out, size_t capacity) {
+  if (codec == Codec::BINARY) {
+    BinaryWriter writer(out, capacity, MessageType::ASSIGN);
+    writer.u8(msg.slot);
+    writer.u8(msg.color.r);
+    writer.u8(msg.color.g);
+    writer.u8(msg.color.b);
+    return writer.finish();
+  }
+
+  StaticJsonDocument<200> doc;
+  doc[JsonKey::SLOT] = msg.slot;
+  char colorHex[8];
+  snprintf(colorHex, sizeof(colorHex), "#%02X%02X%02X", msg.color.r, msg.color.g, msg.color.b);
+  doc[JsonKey::COLOR] = colorHex;
+  return finishJson(doc, out, capacity);
+}
+
+bool decode(const uint8_t* payload, size_t length, AssignMessage& msg) {
+  if (isBinary(payload, length)) {
+    BinaryReader reader(payload, length, MessageType::ASSIGN);
+    msg.slot = reader.u8();
+    msg.color.r = reader.u8();
+    msg.color.g = reader.u8();
+    msg.color.b = reader.u8();
+    return reader.ok();
+  }
+
+  StaticJsonDocument<200> doc;
+  if (deserializeJson(doc, payload, length)) return false;
+
+  // Parse color hex string (#RRGGBB)
+  const char* colorHex = doc[JsonKey::COLOR] | "";
+  if (strlen(colorHex) != 7 || colorHex[0] != '#') return false;
+
+  uint32_t colorValue = strtol(colorHex + 1, NULL, 16);
+  msg.slot = doc[JsonKey::SLOT];
+  msg.color = Rgb((colorValue >> 16) & 0xFF, (colorValue >> 8) & 0xFF, colorValue & 0xFF);
+  return true;
+}
+
+// State
+size_t encode(const StateMessage& msg, Codec codec, uint8_t* out, size_t capacity) {
+  if (codec == Codec::BINARY) {
+    BinaryWriter writer(out, capacity, MessageType::STATE);
+    writer.u8((uint8_t)msg.phase);
+    writer.u8((msg.locked ? Flag::LOCKED : 0) | (msg.hasOpenAt ? Flag::OPEN_AT : 0) |
+              (msg.hasSequence ? Flag::SEQUENCE : 0));
+    writer.u8(msg.clientCount);
+    if (msg.hasOpenAt) {
+      writer.u32(msg.openAt);
+    }
+    if (msg.hasSequence) {
+      writer.u16(msg.epoch);
+      writer.u16(msg.seq);
+    }
+    return writer.finish();
+  }
+
+  StaticJsonDocument<200> doc;
+  doc[JsonKey::PHASE] = phaseToString(msg.phase);
+  doc[JsonKey::LOCKED] = msg.locked;
+  if (msg.hasOpenAt) {
+    doc[JsonKey::OPEN_AT] = msg.openAt;
+  }
+  doc["gameClientCount"] = msg.clientCount;
+  if (msg.hasSequence) {
+    doc[JsonKey::EPOCH] = msg.epoch;
+    doc[JsonKey::SEQUENCE] = msg.seq;
+  }
+  return finishJson(doc, out, capacity);
+}
+
+bool decode(const uint8_t* payload, size_t length, StateMessage& msg) {
+  if (isBinary(payload, length)) {
+    BinaryReader reader(payload, length, MessageType::STATE);
+    uint8_t phase = reader.u8();
+    uint8_t flags = reader.u8();
+    msg.phase = phase <= (uint8_t)Phase::RESET ? (Phase)phase : Phase::BOOT;
+    msg.locked = flags & Flag::LOCKED;
+    msg.clientCount = reader.u8();
+    msg.hasOpenAt = flags & Flag::OPEN_AT;
+    msg.openAt = msg.hasOpenAt ? reader.u32() : 0;
+    msg.hasSequence = flags & Flag::SEQUENCE;
+    msg.epoch = msg.hasSequence ? reader.u16() : 0;
+    msg.seq = msg.hasSequence ? reader.u16() : 0;
+    return reader.ok();
+  }
+
+  StaticJsonDocument<200> doc;
+  if (deserializeJson(doc, payload, length)) return false;
+
+  msg.phase = stringToPhase(doc[JsonKey::PHASE] | "");
+  msg.locked = doc[JsonKey::LOCKED] | false;
+  msg.hasOpenAt = doc.containsKey(JsonKey::OPEN_AT);
+  msg.openAt = doc[JsonKey::OPEN_AT] | 0u;
+  msg.clientCount = doc["gameClientCount"] | 0;
+  msg.hasSequence = doc.containsKey(JsonKey::SEQUENCE);
+  msg.epoch = doc[JsonKey::EPOCH] | 0;
+  msg.seq = doc[JsonKey::SEQUENCE] | 0;
+  return true;
+}
+
+// Queue
+size_t encode(const QueueMessage& msg, Codec codec, uint8_t* out, size_t capacity) {
+  if (codec == Codec::BINARY) {
+    BinaryWriter writer(out, capacity, MessageType::QUEUE);
+    writer.u8(msg.length);
+    writer.u8((uint8_t)msg.active);
+    for (uint8_t i = 0; i < msg.length; i++) {
+      writer.str(msg.order[i]);
+    }
+    // Appended - older firmware stops reading before it
+    if (msg.hasSequence) {
+      writer.u16(msg.epoch);
+      writer.u16(msg.seq);
+    }
+    return writer.finish();
+  }
+
+  StaticJsonDocument<300> doc;
+  JsonArray order = doc.createNestedArray(JsonKey::ORDER);
+  for (uint8_t i = 0; i < msg.length; i++) {
+    order.add(msg.order[i]);
+  }
+  if (msg.active >= 0 && msg.active < msg.length) {
+    doc[JsonKey::ACTIVE] = msg.order[msg.active];
+  }
+  if (msg.hasSequence) {
+    doc[JsonKey::EPOCH] = msg.epoch;
+    doc[JsonKey::SEQUENCE] = msg.seq;
+  }
+  return finishJson(doc, out, capacity);
+}
+
+bool decode(const uint8_t* payload, size_t length, QueueMessage& msg) {
+  if (isBinary(payload, length)) {
+    BinaryReader reader(payload, length, MessageType::QUEUE);
+    msg.length = reader.u8();
+    msg.active = (int8_t)reader.u8();
+    if (msg.length > MAX_CLIENTS) return false;
+    for (uint8_t i = 0; i < msg.length; i++) {
+      reader.str(msg.order[i], sizeof(msg.order[i]));
+    }
+    msg.hasSequence = reader.ok() && !reader.atEnd();
+    msg.epoch = msg.hasSequence ? reader.u16() : 0;
+    msg.seq = msg.hasSequence ? reader.u16() : 0;
+    return reader.ok() && msg.active < msg.length;
+  }
+
+  StaticJsonDocument<300> doc;
+  if (deserializeJson(doc, payload, length)) return false;
+
+  const char* active = doc[JsonKey::ACTIVE] | "";
+  msg.length = 0;
+  msg.active = -1;
+  for (JsonVariant id : doc[JsonKey::ORDER].as<JsonArray>()) {
+    if (msg.length >= MAX_CLIENTS) break;
+    strlcpy(msg.order[msg.length], id | "", sizeof(msg.order[msg.length]));
+    if (msg.active < 0 && strcmp(msg.order[msg.length], active) == 0) {
+      msg.active = msg.length;
+    }
+    msg.length++;
+  }
+  msg.hasSequence = doc.containsKey(JsonKey::SEQUENCE);
+  msg.epoch = doc[JsonKey::EPOCH] | 0;
+  msg.seq = doc[JsonKey::SEQUENCE] | 0;
+  return true;
+}
+
+// Command
+size_t encode(const CommandMessage& msg, Codec codec, uint8_t* out, size_t capacity) {
+  if (codec == Codec::BINARY) {
+    BinaryWriter writer(out, capacity, MessageType::CMD);
+    writer.u8((uint8_t)msg.cmd);
+    writer.u8((msg.hasStart ? Flag::START : 0) | (msg.hasTimestamp ? Flag::TIMESTAMP : 0));
+    writer.str(msg.target);
+    if (msg.hasStart) {
+      writer.u32(msg.start);
+    }
+    if (msg.hasTimestamp) {
+      writer.u32(msg.timestamp);
+    }
+    return writer.finish();
+  }
+
+  StaticJsonDocument<200> doc;
+  doc[JsonKey::CMD] = commandToString(msg.cmd);
+  if (msg.target[0] != '\0') {
+    doc[JsonKey::TARGET] = msg.target;
+  }
+  if (msg.hasStart) {
+    doc[JsonKey::START] = msg.start;
+  }
+  if (msg.hasTimestamp) {
+    doc[JsonKey::TIMESTAMP] = msg.timestamp;
+  }
+  return finishJson(doc, out, capacity);
+}
+
+bool decode(const uint8_t* payload, size_t length, CommandMessage& msg) {
+  if (isBinary(payload, length)) {
+    BinaryReader reader(payload, length, MessageType::CMD);
+    msg.cmd = (CommandType)reader.u8();
+    uint8_t flags = reader.u8();
+    reader.str(msg.target, sizeof(msg.target));
+    msg.hasStart = flags & Flag::START;
+    msg.start = msg.hasStart ? reader.u32() : 0;
+    msg.hasTimestamp = flags & Flag::TIMESTAMP;
+    msg.timestamp = msg.hasTimestamp ? reader.u32() : 0;
+    return reader.ok();
+  }
+
+  StaticJsonDocument<200> doc;
+  if (deserializeJson(doc, payload, length)) return false;
+
+  msg.cmd = stringToCommand(doc[JsonKey::CMD] | "");
+  strlcpy(msg.target, doc[JsonKey::TARGET] | "", sizeof(msg.target));
+  msg.hasStart = doc.containsKey(JsonKey::START);
+  msg.start = doc[JsonKey::START] | 0u;
+  msg.hasTimestamp = doc.containsKey(JsonKey::TIMESTAMP);
+  msg.timestamp = doc[JsonKey::TIMESTAMP] | 0u;
+  return true;
+}
+
+// Buzz ack
+size_t encode(const AckMessage& msg, Codec codec, uint8_t* out, size_t capacity) {
+  if (codec == Codec::BINARY) {
+    BinaryWriter writer(out, capacity, MessageType::ACK);
+    writer.u8(msg.position);
+    writer.u8(msg.falseStart ? Flag::FALSE_START : 0);
+    writer.u16(msg.seq);
+    writer.u32(msg.receiveTime);
+    writer.u32(msg.pressTime);
+    return writer.finish();
+  }
+
+  StaticJsonDocument<100> doc;
+  doc[JsonKey::POSITION] = msg.position;
+  doc[JsonKey::TIMESTAMP] = msg.receiveTime;
+  doc[JsonKey::ECHO] = msg.pressTime;
+  if (msg.seq > 0) {
+    doc[JsonKey::SEQUENCE] = msg.seq;
+  }
+  if (msg.falseStart) {
+    doc[JsonKey::FALSE_START] = true;
+  }
+  return finishJson(doc, out, capacity);
+}
+
+bool decode(const uint8_t* payload, size_t length, AckMessage& msg) {
+  if (isBinary(payload, length)) {
+    BinaryReader reader(payload, length, MessageType::ACK);
+    msg.position = reader.u8();
+    msg.falseStart = reader.u8() & Flag::FALSE_START;
+    msg.seq = reader.u16();
+    msg.receiveTime = reader.u32();
+    msg.pressTime = reader.u32();
+    return reader.ok();
+  }
+
+  StaticJsonDocument<100> doc;
+  if (deserializeJson(doc, payload, length)) return false;
+
+  msg.position = doc[JsonKey::POSITION] | 0;
+  msg.receiveTime = doc[JsonKey::TIMESTAMP] | 0u;
+  msg.pressTime = doc[JsonKey::ECHO] | 0u;
+  msg.seq = doc[JsonKey::SEQUENCE] | 0;
+  msg.falseStart = doc[JsonKey::FALSE_START] | false;
+  return true;
+}
+
+// Clock sync
+size_t encode(const SyncMessage& msg, Codec codec, uint8_t* out, size_t capacity) {
+  if (codec == Codec::BINARY) {
+    BinaryWriter writer(out, capacity, MessageType::SYNC);
+    writer.u32(msg.echo);
+    writer.u32(msg.serverTime);
+    return writer.finish();
+  }
+
+  StaticJsonDocument<100> doc;
+  doc[JsonKey::ECHO] = msg.echo;
+  doc[JsonKey::TIMESTAMP] = msg.serverTime;
+  return finishJson(doc, out, capacity);
+}
+
+bool decode(const uint8_t* payload, size_t length, SyncMessage& msg) {
+  if (isBinary(payload, length)) {
+    BinaryReader reader(payload, length, MessageType::SYNC);
+    msg.echo = reader.u32();
+    msg.serverTime = reader.u32();
+    return reader.ok();
+  }
+
+  StaticJsonDocument<100> doc;
+  if (deserializeJson(doc, payload, length)) return false;
+
+  msg.echo = doc[JsonKey::ECHO] | 0u;
+  msg.serverTime = doc[JsonKey::TIMESTAMP] | 0u;
+  return true;
+}
+
+// Buzz - field order matches buzzSeqOffset/buzzFlagsOffset/buzzTimeOffset
+size_t encode(const BuzzMessage& msg, Codec codec, uint8_t* out, size_t capacity) {
+  if (codec == Codec::BINARY) {
+    BinaryWriter writer(out, capacity, MessageType::BUZZ);
+    writer.str(msg.id);
+    writer.u16(msg.seq);
+    writer.u8((msg.hasTimestamp ? Flag::TIMESTAMP : 0) | (msg.hubTime ? Flag::HUB_TIME : 0) |
+              (msg.falseStart ? Flag::FALSE_START : 0));
+    writer.u32(msg.timestamp);
+    return writer.finish();
+  }
+
+  StaticJsonDocument<200> doc;
+  doc[JsonKey::ID] = msg.id;
+  doc[JsonKey::SEQUENCE] = msg.seq;
+  if (msg.hasTimestamp) {
+    doc[msg.hubTime ? JsonKey::HUB_TIME : JsonKey::TIMESTAMP] = msg.timestamp;
+  }
+  if (msg.falseStart) {
+    doc[JsonKey::FALSE_START] = true;
+  }
+  return finishJson(doc, out, capacity);
+}
+
+bool decode(const uint8_t* payload, size_t length, BuzzMessage& msg) {
+  if (isBinary(payload, length)) {
+    BinaryReader reader(payload, length, MessageType::BUZZ);
+    reader.str(msg.id, sizeof(msg.id));
+    msg.seq = reader.u16();
+    uint8_t flags = reader.u8();
+    msg.hasTimestamp = flags & Flag::TIMESTAMP;
+    msg.hubTime = flags & Flag::HUB_TIME;
+    msg.falseStart = flags & Flag::FALSE_START;
+    msg.timestamp = reader.u32();
+    return reader.ok();
+  }
+
+  StaticJsonDocument<200> doc;
+  if (deserializeJson(doc, payload, length)) return false;
+
+  strlcpy(msg.id, doc[JsonKey::ID] | "", sizeof(msg.id));
+  msg.seq = doc[JsonKey::SEQUENCE] | 0;
+  msg.hubTime = doc.containsKey(JsonKey::HUB_TIME);
+  msg.hasTimestamp = msg.hubTime || doc.containsKey(JsonKey::TIMESTAMP);
+  msg.timestamp = msg.hubTime ? (doc[JsonKey::HUB_TIME] | 0u) : (doc[JsonKey::TIMESTAMP] | 0u);
+  msg.falseStart = doc[JsonKey::FALSE_START] | false;
+  return true;
+}
+
+// Ping
+size_t encode(const PingMessage& msg, Codec codec, uint8_t* out, size_t capacity) {
+  if (codec == Codec::BINARY) {
+    BinaryWriter writer(out, capacity, MessageType::PING);
+    writer.str(msg.id);
+    writer.u8((msg.hasTimestamp ? Flag::TIMESTAMP : 0) | (msg.hasEcho ? Flag::ECHO : 0));
+    if (msg.hasTimestamp) {
+      writer.u32(msg.timestamp);
+    }
+    if (msg.hasEcho) {
+      writer.u32(msg.echo);
+    }
+    return writer.finish();
+  }
+
+  StaticJsonDocument<100> doc;
+  doc[JsonKey::ID] = msg.id;
+  if (msg.hasTimestamp) {
+    doc[JsonKey::TIMESTAMP] = msg.timestamp;
+  }
+  if (msg.hasEcho) {
+    doc[JsonKey::ECHO] = msg.echo;
+  }
+  return finishJson(doc, out, capacity);
+}
+
+bool decode(const uint8_t* payload, size_t length, PingMessage& msg) {
+  if (isBinary(payload, length)) {
+    BinaryReader reader(payload, length, MessageType::PING);
+    reader.str(msg.id, sizeof(msg.id));
+    uint8_t flags = reader.u8();
+    msg.hasTimestamp = flags & Flag::TIMESTAMP;
+    msg.timestamp = msg.hasTimestamp ? reader.u32() : 0;
+    msg.hasEcho = flags & Flag::ECHO;
+    msg.echo = msg.hasEcho ? reader.u32() : 0;
+    return reader.ok();
+  }
+
+  StaticJsonDocument<100> doc;
+  if (deserializeJson(doc, payload, length)) return false;
+
+  strlcpy(msg.id, doc[JsonKey::ID] | "", sizeof(msg.id));
+  msg.hasTimestamp = doc.containsKey(JsonKey::TIMESTAMP);
+  msg.timestamp = doc[JsonKey::TIMESTAMP] | 0u;
+  msg.hasEcho = doc.containsKey(JsonKey::ECHO);
+  msg.echo = doc[JsonKey::ECHO] | 0u;
+  return true;
+}
+
+// Queue delta
+size_t encode(const QueueDeltaMessage& msg, uint8_t* out, size_t capacity) {
+  BinaryWriter writer(out, capacity, MessageType::QUEUE_DELTA);
+  writer.u16(msg.epoch);
+  writer.u16(msg.seq);
+  writer.u16(msg.base);
+  writer.u8((uint8_t)msg.op);
+  writer.u8(msg.position);
+  writer.u8((uint8_t)msg.active);
+  if (msg.op == QueueOp::PUSH) {
+    writer.str(msg.id);
+  }
+  return writer.finish();
+}
+
+bool decode(const uint8_t* payload, size_t length, QueueDeltaMessage& msg) {
+  BinaryReader reader(payload, length, MessageType::QUEUE_DELTA);
+  msg.epoch = reader.u16();
+  msg.seq = reader.u16();
+  msg.base = reader.u16();
+  uint8_t op = reader.u8();
+  msg.op = (QueueOp)op;
+  msg.position = reader.u8();
+  msg.active = (int8_t)reader.u8();
+  msg.id[0] = '\0';
+  if (msg.op == QueueOp::PUSH) {
+    reader.str(msg.id, sizeof(msg.id));
+  }
+  return reader.ok() && (op == (uint8_t)QueueOp::PUSH || op == (uint8_t)QueueOp::POP) &&
+         msg.position < MAX_CLIENTS;
+}
+
+// Snapshot
+size_t encode(const SnapshotMessage& msg, uint8_t* out, size_t capacity) {
+  BinaryWriter writer(out, capacity, MessageType::SNAPSHOT);
+  writer.u8(msg.slot);
+  writer.u8(msg.color.r);
+  writer.u8(msg.color.g);
+  writer.u8(msg.color.b);
+  writer.u8((uint8_t)msg.phase);
+  writer.u8((msg.locked ? Flag::LOCKED : 0) | (msg.hasOpenAt ? Flag::OPEN_AT : 0) |
+            (msg.active ? Flag::ACTIVE : 0));
+  writer.u8(msg.position);
+  if (msg.hasOpenAt) {
+    writer.u32(msg.openAt);
+  }
+  writer.u16(msg.epoch);
+  writer.u16(msg.seq);
+  return writer.finish();
+}
+
+bool decode(const uint8_t* payload, size_t length, SnapshotMessage& msg) {
+  BinaryReader reader(payload, length, MessageType::SNAPSHOT);
+  msg.slot = reader.u8();
+  msg.color.r = reader.u8();
+  msg.color.g = reader.u8();
+  msg.color.b = reader.u8();
+  uint8_t phase = reader.u8();
+  uint8_t flags = reader.u8();
+  msg.phase = phase <= (uint8_t)Phase::RESET ? (Phase)phase : Phase::BOOT;
+  msg.locked = flags & Flag::LOCKED;
+  msg.hasOpenAt = flags & Flag::OPEN_AT;
+  msg.active = flags & Flag::ACTIVE;
+  msg.position = reader.u8();
+  msg.openAt = msg.hasOpenAt ? reader.u32() : 0;
+  msg.epoch = reader.u16();
+  msg.seq = reader.u16();
+  return reader.ok() && msg.position <= MAX_CLIENTS;
+}
+
+// Batch
+size_t beginBatch(uint8_t* out, size_t capacity) {
+  BinaryWriter writer(out, capacity, MessageType::BATCH);
+  return writer.finish();
+}
+
+size_t appendToBatch(uint8_t* batch, size_t length, size_t capacity, const uint8_t* frame, size_t frameLength) {
+  if (length < 2 || frameLength == 0 || frameLength > 0xFF || length + 1 + frameLength > capacity) {
+    return 0;
+  }
+  batch[length] = frameLength;
+  memcpy(batch + length + 1, frame, frameLength);
+  return length + 1 + frameLength;
+}
+
+bool nextBatchFrame(const uint8_t* batch, size_t length, size_t& offset, const uint8_t*& frame, size_t& frameLength) {
+  if (!isBatch(batch, length)) return false;
+  if (offset < 2) offset = 2;
+  if (offset >= length) return false;
+  
+  frameLength = batch[offset];
+  if (frameLength == 0 || offset + 1 + frameLength > length) return false;
+  frame = batch + offset + 1;
+  offset += 1 + frameLength;
+  return true;
+}
+
+}
@@ -0,0 +1,25 @@
+#pragma once
+// Host stand-in for the Arduino core, [env:native] only - just the types,
+// C string helpers and attribute macros the hardware-free modules use
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+#define IRAM_ATTR
+#define LOW 0
+#define HIGH 1
+typedef uint8_t byte;
+
+// glibc before 2.38 has no strlcpy
+#if defined(__GLIBC__) && !__GLIBC_PREREQ(2, 38)
+inline size_t strlcpy(char* dst, const char* src, size_t size) {
+  size_t length = strlen(src);
+  if (size > 0) {
+    size_t n = length < size - 1 ? length : size - 1;
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+  }
+  return length;
+}
+#endif
@@ -0,0 +1,169 @@
+#include <unity.h>
+#include "button_debounce.h"
+
+// Edge traces modelled on tactile switch bounce: press chatter for 1-5 ms
+// after the first contact, release chatter for a few ms, the odd glitch
+// while held. Times in us from the start of the trace.
+struct Edge {
+  int64_t timeUs;
+  bool down;
+};
+
+// Loop polls every 2 ms while a question is open (EVENT_POLL_ACTIVE_MS)
+constexpr int64_t POLL_US = (int64_t)EVENT_POLL_ACTIVE_MS * 1000;
+
+struct Replay {
+  uint8_t presses;
+  int64_t pressTimeUs[8];
+  int64_t detectedUs[8];   // poll that reported the press
+};
+
+// Falling edges run through the interrupt path as they happen, the loop
+// polls the level every pollUs until endUs and consumes each press
+static Replay replay(ButtonDebouncer& debouncer, const Edge* edges, size_t count,
+                     int64_t endUs, bool interrupts = true, int64_t pollUs = POLL_US) {
+  Replay result = {};
+  bool level = false;
+  size_t next = 0;
+
+  for (int64_t now = 0; now <= endUs; now += pollUs) {
+    while (next < count && edges[next].timeUs <= now) {
+      level = edges[next].down;
+      if (interrupts && level) {
+        debouncer.captureEdge(true, edges[next].timeUs);
+      }
+      next++;
+    }
+    debouncer.update(level, now);
+    if (debouncer.wasPressed() && result.presses < 8) {
+      result.pressTimeUs[result.presses] = debouncer.getPressTimeUs();
+      result.detectedUs[result.presses] = now;
+      result.presses++;
+    }
+  }
+  return result;
+}
+
+static const Edge CLEAN_PRESS[] = {
+  {10000, true}, {150000, false}
+};
+
+static const Edge PRESS_CHATTER[] = {
+  {10000, true}, {10300, false}, {10700, true}, {11900, false}, {12100, true},
+  {13800, false}, {14000, true}, {150000, false}
+};
+
+static const Edge RELEASE_CHATTER[] = {
+  {10000, true}, {150000, false}, {150400, true}, {151100, false}, {152600, true},
+  {153000, false}, {155200, true}, {155500, false}
+};
+
+// Contact opens briefly while held, well after the lock-out
+static const Edge GLITCH_WHILE_HELD[] = {
+  {10000, true}, {80000, false}, {80600, true}, {150000, false}
+};
+
+// Two deliberate presses, the second one bouncing too
+static const Edge DOUBLE_PRESS[] = {
+  {10000, true}, {10500, false}, {11000, true}, {120000, false}, {121000, true},
+  {121500, false}, {300000, true}, {300200, false}, {301000, true}, {400000, false}
+};
+
+void setUp() {}
+void tearDown() {}
+
+void test_clean_press_fires_once_at_edge() {
+  ButtonDebouncer debouncer(DebounceMode::LOCK_OUT);
+  Replay r = replay(debouncer, CLEAN_PRESS, 2, 300000);
+
+  TEST_ASSERT_EQUAL_UINT8(1, r.presses);
+  TEST_ASSERT_EQUAL_INT64(10000, r.pressTimeUs[0]);
+}
+
+void test_press_chatter_is_one_buzz() {
+  ButtonDebouncer debouncer(DebounceMode::LOCK_OUT);
+  Replay r = replay(debouncer, PRESS_CHATTER, 8, 300000);
+
+  TEST_ASSERT_EQUAL_UINT8(1, r.presses);
+  TEST_ASSERT_EQUAL_INT64(10000, r.pressTimeUs[0]);
+}
+
+void test_release_chatter_is_no_second_buzz() {
+  ButtonDebouncer debouncer(DebounceMode::LOCK_OUT);
+  Replay r = replay(debouncer, RELEASE_CHATTER, 8, 300000);
+
+  TEST_ASSERT_EQUAL_UINT8(1, r.presses);
+}
+
+void test_glitch_while_held_is_no_second_buzz() {
+  ButtonDebouncer debouncer(DebounceMode::LOCK_OUT);
+  Replay r = replay(debouncer, GLITCH_WHILE_HELD, 4, 300000);
+
+  TEST_ASSERT_EQUAL_UINT8(1, r.presses);
+}
+
+void test_separate_presses_both_count() {
+  ButtonDebouncer debouncer(DebounceMode::LOCK_OUT);
+  Replay r = replay(debouncer, DOUBLE_PRESS, 10, 500000);
+
+  TEST_ASSERT_EQUAL_UINT8(2, r.presses);
+  TEST_ASSERT_EQUAL_INT64(10000, r.pressTimeUs[0]);
+  TEST_ASSERT_EQUAL_INT64(300000, r.pressTimeUs[1]);
+}
+
+// Lock-out adds no latency: the press carries the first edge's time and is
+// reported by the first poll after it, whatever the chatter does
+void test_lock_out_adds_no_latency() {
+  ButtonDebouncer debouncer(DebounceMode::LOCK_OUT);
+  Replay r = replay(debouncer, PRESS_CHATTER, 8, 300000);
+
+  TEST_ASSERT_EQUAL_INT64(PRESS_CHATTER[0].timeUs, r.pressTimeUs[0]);
+  TEST_ASSERT_TRUE(r.detectedUs[0] - PRESS_CHATTER[0].timeUs < POLL_US);
+}
+
+// Stable mode for comparison - same press time from the edge, but reported
+// only once the contact has settled for DEBOUNCE_MS
+void test_stable_reports_after_settling() {
+  ButtonDebouncer debouncer(DebounceMode::STABLE);
+  Replay r = replay(debouncer, PRESS_CHATTER, 8, 300000);
+
+  TEST_ASSERT_EQUAL_UINT8(1, r.presses);
+  TEST_ASSERT_EQUAL_INT64(PRESS_CHATTER[0].timeUs, r.pressTimeUs[0]);
+  int64_t settledUs = PRESS_CHATTER[6].timeUs; // last contact edge
+  TEST_ASSERT_TRUE(r.detectedUs[0] - settledUs >= (int64_t)DEBOUNCE_MS * 1000);
+}
+
+// Interrupt missed - the level still registers the press, at poll time
+void test_missed_interrupt_falls_back_to_level() {
+  ButtonDebouncer debouncer(DebounceMode::LOCK_OUT);
+  Replay r = replay(debouncer, PRESS_CHATTER, 8, 300000, false);
+
+  TEST_ASSERT_EQUAL_UINT8(1, r.presses);
+  TEST_ASSERT_TRUE(r.pressTimeUs[0] >= PRESS_CHATTER[0].timeUs);
+  TEST_ASSERT_TRUE(r.pressTimeUs[0] - PRESS_CHATTER[0].timeUs < POLL_US);
+}
+
+// Interrupt fired but the pin was already back HIGH - a spike, not a press
+void test_spike_is_ignored() {
+  ButtonDebouncer debouncer(DebounceMode::LOCK_OUT);
+  debouncer.captureEdge(false, 5000);
+  for (int64_t now = 0; now <= 100000; now += POLL_US) {
+    debouncer.update(false, now);
+  }
+
+  TEST_ASSERT_FALSE(debouncer.wasPressed());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_clean_press_fires_once_at_edge);
+  RUN_TEST(test_press_chatter_is_one_buzz);
+  RUN_TEST(test_release_chatter_is_no_second_buzz);
+  RUN_TEST(test_glitch_while_held_is_no_second_buzz);
+  RUN_TEST(test_separate_presses_both_count);
+  RUN_TEST(test_lock_out_adds_no_latency);
+  RUN_TEST(test_stable_reports_after_settling);
+  RUN_TEST(test_missed_interrupt_falls_back_to_level);
+  RUN_TEST(test_spike_is_ignored);
+  return UNITY_END();
+}
@@ -0,0 +1,165 @@
+#include <unity.h>
+#include "buzz_queue.h"
+
+static BuzzQueue queue;
+
+// Buzz as the server does it - queue the client and remember it buzzed
+static void buzz(uint8_t client) {
+  TEST_ASSERT_TRUE(queue.push(client));
+  queue.markBuzzed(client);
+}
+
+void setUp() {
+  queue.clear();
+}
+
+void tearDown() {}
+
+void test_starts_empty() {
+  TEST_ASSERT_TRUE(queue.isEmpty());
+  TEST_ASSERT_FALSE(queue.isFull());
+  TEST_ASSERT_EQUAL_UINT8(0, queue.size());
+  TEST_ASSERT_EQUAL_UINT8(UINT8_MAX, queue.popFront());
+  TEST_ASSERT_FALSE(queue.remove(0));
+}
+
+void test_keeps_buzz_order() {
+  buzz(3);
+  buzz(0);
+  buzz(7);
+
+  TEST_ASSERT_EQUAL_UINT8(3, queue.size());
+  TEST_ASSERT_EQUAL_UINT8(3, queue.at(0));
+  TEST_ASSERT_EQUAL_UINT8(0, queue.at(1));
+  TEST_ASSERT_EQUAL_UINT8(7, queue.at(2));
+  TEST_ASSERT_EQUAL_INT8(2, queue.find(7));
+  TEST_ASSERT_EQUAL_INT8(-1, queue.find(5));
+}
+
+// NEXT button - answering client leaves, the next one moves to the front
+// and the wrong client may buzz again, ending up at the back
+void test_wrong_answer_moves_to_next() {
+  buzz(2);
+  buzz(5);
+  buzz(1);
+
+  uint8_t wrong = queue.at(0);
+  queue.clearBuzzed(wrong);
+  TEST_ASSERT_TRUE(queue.remove(0));
+
+  TEST_ASSERT_EQUAL_UINT8(2, queue.size());
+  TEST_ASSERT_EQUAL_UINT8(5, queue.at(0));
+  TEST_ASSERT_EQUAL_UINT8(1, queue.at(1));
+  TEST_ASSERT_FALSE(queue.hasBuzzed(2));
+  TEST_ASSERT_EQUAL_INT8(-1, queue.find(2));
+
+  buzz(2);
+  TEST_ASSERT_EQUAL_INT8(2, queue.find(2));
+}
+
+// New question - nobody is queued and everybody may buzz again
+void test_rebuzz_after_reset() {
+  buzz(4);
+  buzz(6);
+  queue.markBuzzed(8); // still held in the arbitration window
+
+  queue.clear();
+
+  TEST_ASSERT_TRUE(queue.isEmpty());
+  TEST_ASSERT_FALSE(queue.hasBuzzed(4));
+  TEST_ASSERT_FALSE(queue.hasBuzzed(6));
+  TEST_ASSERT_FALSE(queue.hasBuzzed(8));
+
+  buzz(6);
+  TEST_ASSERT_EQUAL_UINT8(6, queue.at(0));
+  TEST_ASSERT_EQUAL_INT8(0, queue.find(6));
+}
+
+// Pops move head around the ring, positions stay contiguous
+void test_wraps_around_the_ring() {
+  for (uint8_t round = 0; round < 3 * MAX_CLIENTS; round++) {
+    uint8_t client = round % MAX_CLIENTS;
+    TEST_ASSERT_TRUE(queue.push(client));
+    TEST_ASSERT_TRUE(queue.push((client + 1) % MAX_CLIENTS));
+    TEST_ASSERT_EQUAL_UINT8(client, queue.popFront());
+    TEST_ASSERT_EQUAL_UINT8((client + 1) % MAX_CLIENTS, queue.at(0));
+    TEST_ASSERT_EQUAL_UINT8((client + 1) % MAX_CLIENTS, queue.popFront());
+    TEST_ASSERT_TRUE(queue.isEmpty());
+  }
+
+  // Fill across the wrap point, then read back in order
+  TEST_ASSERT_TRUE(queue.push(9));
+  TEST_ASSERT_EQUAL_UINT8(9, queue.popFront());
+  for (uint8_t i = 0; i < MAX_CLIENTS; i++) {
+    TEST_ASSERT_TRUE(queue.push(i));
+  }
+  for (uint8_t i = 0; i < MAX_CLIENTS; i++) {
+    TEST_ASSERT_EQUAL_UINT8(i, queue.at(i));
+  }
+}
+
+void test_full_rejects_more() {
+  for (uint8_t i = 0; i < MAX_CLIENTS; i++) {
+    buzz(i);
+  }
+
+  TEST_ASSERT_TRUE(queue.isFull());
+  TEST_ASSERT_FALSE(queue.push(0));
+  TEST_ASSERT_FALSE(queue.insert(0, 0));
+  TEST_ASSERT_EQUAL_UINT8(MAX_CLIENTS, queue.size());
+
+  for (uint8_t i = 0; i < MAX_CLIENTS; i++) {
+    TEST_ASSERT_EQUAL_UINT8(i, queue.popFront());
+  }
+  TEST_ASSERT_TRUE(queue.isEmpty());
+  TEST_ASSERT_EQUAL_UINT8(UINT8_MAX, queue.popFront());
+}
+
+// Late buzz with an earlier press time goes in ahead of later presses
+void test_sorted_insert_shifts_tail() {
+  buzz(1);
+  buzz(2);
+  buzz(3);
+
+  TEST_ASSERT_TRUE(queue.insert(1, 4));
+  TEST_ASSERT_FALSE(queue.insert(6, 5)); // past the end
+
+  TEST_ASSERT_EQUAL_UINT8(4, queue.size());
+  TEST_ASSERT_EQUAL_UINT8(1, queue.at(0));
+  TEST_ASSERT_EQUAL_UINT8(4, queue.at(1));
+  TEST_ASSERT_EQUAL_UINT8(2, queue.at(2));
+  TEST_ASSERT_EQUAL_UINT8(3, queue.at(3));
+}
+
+void test_remove_mid_queue_keeps_order() {
+  // Start off the ring's first slot so the shift crosses the wrap point
+  for (uint8_t i = 0; i < MAX_CLIENTS - 2; i++) {
+    queue.push(0);
+    queue.popFront();
+  }
+  buzz(1);
+  buzz(2);
+  buzz(3);
+  buzz(4);
+
+  TEST_ASSERT_TRUE(queue.remove(1));
+  TEST_ASSERT_FALSE(queue.remove(3)); // past the end
+
+  TEST_ASSERT_EQUAL_UINT8(3, queue.size());
+  TEST_ASSERT_EQUAL_UINT8(1, queue.at(0));
+  TEST_ASSERT_EQUAL_UINT8(3, queue.at(1));
+  TEST_ASSERT_EQUAL_UINT8(4, queue.at(2));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_starts_empty);
+  RUN_TEST(test_keeps_buzz_order);
+  RUN_TEST(test_wrong_answer_moves_to_next);
+  RUN_TEST(test_rebuzz_after_reset);
+  RUN_TEST(test_wraps_around_the_ring);
+  RUN_TEST(test_full_rejects_more);
+  RUN_TEST(test_sorted_insert_shifts_tail);
+  RUN_TEST(test_remove_mid_queue_keeps_order);
+  return UNITY_END();
+}
@@ -0,0 +1,441 @@
+#include <unity.h>
+#include <chrono>
+#include "wire_codec.h"
+
+using Wire::Codec;
+
+static uint8_t buffer[WIRE_FRAME_MAX];
+
+// Typical traffic of a running question - client IDs are "C-" + 8 hex digits
+static Wire::StateMessage makeState(bool withSequence) {
+  Wire::StateMessage msg = {};
+  msg.phase = Phase::ARMED;
+  msg.locked = true;
+  msg.hasOpenAt = true;
+  msg.openAt = 123456789;
+  msg.clientCount = 10;
+  msg.hasSequence = withSequence;
+  msg.epoch = withSequence ? 0xBEEF : 0;
+  msg.seq = withSequence ? 42 : 0;
+  return msg;
+}
+
+static Wire::QueueMessage makeQueue(uint8_t length, bool withSequence) {
+  Wire::QueueMessage msg = {};
+  msg.length = length;
+  msg.active = length > 0 ? 0 : -1;
+  for (uint8_t i = 0; i < length; i++) {
+    snprintf(msg.order[i], sizeof(msg.order[i]), "C-%08x", 0x1a2b3c00 + i);
+  }
+  msg.hasSequence = withSequence;
+  msg.epoch = withSequence ? 0xBEEF : 0;
+  msg.seq = withSequence ? 43 : 0;
+  return msg;
+}
+
+static Wire::CommandMessage makeCommand() {
+  Wire::CommandMessage msg = {};
+  msg.cmd = CommandType::WRONG_FLASH;
+  strlcpy(msg.target, "C-1a2b3c4d", sizeof(msg.target));
+  msg.hasStart = true;
+  msg.start = 123456999;
+  return msg;
+}
+
+static Wire::AckMessage makeAck() {
+  Wire::AckMessage msg = {};
+  msg.position = 3;
+  msg.receiveTime = 123457000;
+  msg.pressTime = 98765;
+  msg.seq = 7;
+  msg.falseStart = false;
+  return msg;
+}
+
+static Wire::SyncMessage makeSync() {
+  Wire::SyncMessage msg = {};
+  msg.echo = 98765;
+  msg.serverTime = 123457000;
+  return msg;
+}
+
+static Wire::BuzzMessage makeBuzz() {
+  Wire::BuzzMessage msg = {};
+  strlcpy(msg.id, "C-1a2b3c4d", sizeof(msg.id));
+  msg.seq = 7;
+  msg.hasTimestamp = true;
+  msg.hubTime = false;
+  msg.timestamp = 98765;
+  msg.falseStart = false;
+  return msg;
+}
+
+static Wire::PingMessage makePing() {
+  Wire::PingMessage msg = {};
+  strlcpy(msg.id, "C-1a2b3c4d", sizeof(msg.id));
+  msg.hasTimestamp = true;
+  msg.timestamp = 98765;
+  msg.hasEcho = true;
+  msg.echo = 123457000;
+  return msg;
+}
+
+static Wire::AssignMessage makeAssign() {
+  Wire::AssignMessage msg = {};
+  msg.slot = 4;
+  msg.color = Rgb(255, 128, 0);
+  return msg;
+}
+
+void setUp() {}
+void tearDown() {}
+
+// Round trips - every field survives both codecs
+
+void test_state_round_trip() {
+  for (int c = 0; c < 2; c++) {
+    Codec codec = (Codec)c;
+    Wire::StateMessage in = makeState(true), out = {};
+    size_t length = Wire::encode(in, codec, buffer, sizeof(buffer));
+    TEST_ASSERT_TRUE(length > 0);
+    TEST_ASSERT_EQUAL(codec == Codec::BINARY, Wire::isBinary(buffer, length));
+    TEST_ASSERT_TRUE(Wire::decode(buffer, length, out));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)in.phase, (uint8_t)out.phase);
+    TEST_ASSERT_EQUAL(in.locked, out.locked);
+    TEST_ASSERT_TRUE(out.hasOpenAt);
+    TEST_ASSERT_EQUAL_UINT32(in.openAt, out.openAt);
+    TEST_ASSERT_EQUAL_UINT8(in.clientCount, out.clientCount);
+    TEST_ASSERT_TRUE(out.hasSequence);
+    TEST_ASSERT_EQUAL_UINT16(in.epoch, out.epoch);
+    TEST_ASSERT_EQUAL_UINT16(in.seq, out.seq);
+  }
+}
+
+void test_assign_round_trip() {
+  for (int c = 0; c < 2; c++) {
+    Wire::AssignMessage in = makeAssign(), out = {};
+    size_t length = Wire::encode(in, (Codec)c, buffer, sizeof(buffer));
+    TEST_ASSERT_TRUE(Wire::decode(buffer, length, out));
+    TEST_ASSERT_EQUAL_UINT8(in.slot, out.slot);
+    TEST_ASSERT_EQUAL_UINT8(in.color.r, out.color.r);
+    TEST_ASSERT_EQUAL_UINT8(in.color.g, out.color.g);
+    TEST_ASSERT_EQUAL_UINT8(in.color.b, out.color.b);
+  }
+}
+
+void test_command_round_trip() {
+  for (int c = 0; c < 2; c++) {
+    Wire::CommandMessage in = makeCommand(), out = {};
+    size_t length = Wire::encode(in, (Codec)c, buffer, sizeof(buffer));
+    TEST_ASSERT_TRUE(Wire::decode(buffer, length, out));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)in.cmd, (uint8_t)out.cmd);
+    TEST_ASSERT_EQUAL_STRING(in.target, out.target);
+    TEST_ASSERT_TRUE(out.hasStart);
+    TEST_ASSERT_EQUAL_UINT32(in.start, out.start);
+    TEST_ASSERT_FALSE(out.hasTimestamp);
+  }
+}
+
+void test_ack_round_trip() {
+  for (int c = 0; c < 2; c++) {
+    Wire::AckMessage in = makeAck(), out = {};
+    in.falseStart = c == 0;
+    size_t length = Wire::encode(in, (Codec)c, buffer, sizeof(buffer));
+    TEST_ASSERT_TRUE(Wire::decode(buffer, length, out));
+    TEST_ASSERT_EQUAL_UINT8(in.position, out.position);
+    TEST_ASSERT_EQUAL_UINT32(in.receiveTime, out.receiveTime);
+    TEST_ASSERT_EQUAL_UINT32(in.pressTime, out.pressTime);
+    TEST_ASSERT_EQUAL_UINT16(in.seq, out.seq);
+    TEST_ASSERT_EQUAL(in.falseStart, out.falseStart);
+  }
+}
+
+void test_sync_round_trip() {
+  for (int c = 0; c < 2; c++) {
+    Wire::SyncMessage in = makeSync(), out = {};
+    size_t length = Wire::encode(in, (Codec)c, buffer, sizeof(buffer));
+    TEST_ASSERT_TRUE(Wire::decode(buffer, length, out));
+    TEST_ASSERT_EQUAL_UINT32(in.echo, out.echo);
+    TEST_ASSERT_EQUAL_UINT32(in.serverTime, out.serverTime);
+  }
+}
+
+void test_buzz_round_trip() {
+  for (int c = 0; c < 2; c++) {
+    for (int hub = 0; hub < 2; hub++) {
+      Wire::BuzzMessage in = makeBuzz(), out = {};
+      in.hubTime = hub;
+      in.falseStart = !hub;
+      size_t length = Wire::encode(in, (Codec)c, buffer, sizeof(buffer));
+      TEST_ASSERT_TRUE(Wire::decode(buffer, length, out));
+      TEST_ASSERT_EQUAL_STRING(in.id, out.id);
+      TEST_ASSERT_EQUAL_UINT16(in.seq, out.seq);
+      TEST_ASSERT_TRUE(out.hasTimestamp);
+      TEST_ASSERT_EQUAL(in.hubTime, out.hubTime);
+      TEST_ASSERT_EQUAL_UINT32(in.timestamp, out.timestamp);
+      TEST_ASSERT_EQUAL(in.falseStart, out.falseStart);
+    }
+  }
+}
+
+void test_ping_round_trip() {
+  for (int c = 0; c < 2; c++) {
+    Wire::PingMessage in = makePing(), out = {};
+    size_t length = Wire::encode(in, (Codec)c, buffer, sizeof(buffer));
+    TEST_ASSERT_TRUE(Wire::decode(buffer, length, out));
+    TEST_ASSERT_EQUAL_STRING(in.id, out.id);
+    TEST_ASSERT_TRUE(out.hasTimestamp);
+    TEST_ASSERT_EQUAL_UINT32(in.timestamp, out.timestamp);
+    TEST_ASSERT_TRUE(out.hasEcho);
+    TEST_ASSERT_EQUAL_UINT32(in.echo, out.echo);
+  }
+}
+
+void test_join_round_trip() {
+  Wire::JoinMessage in = {}, out = {};
+  strlcpy(in.id, "C-1a2b3c4d", sizeof(in.id));
+  in.capability = 8;
+  strlcpy(in.firmware, FIRMWARE_VERSION, sizeof(in.firmware));
+  size_t length = Wire::encode(in, buffer, sizeof(buffer));
+  TEST_ASSERT_FALSE(Wire::isBinary(buffer, length));
+  TEST_ASSERT_TRUE(Wire::decode(buffer, length, out));
+  TEST_ASSERT_EQUAL_STRING(in.id, out.id);
+  TEST_ASSERT_EQUAL_UINT8(in.capability, out.capability);
+  TEST_ASSERT_EQUAL_STRING(in.firmware, out.firmware);
+
+  // Firmware 1.0 didn't send its version
+  const char* legacy = "{\"id\":\"C-1a2b3c4d\"}";
+  TEST_ASSERT_TRUE(Wire::decode((const uint8_t*)legacy, strlen(legacy), out));
+  TEST_ASSERT_EQUAL_STRING("1.0", out.firmware);
+  TEST_ASSERT_FALSE(Wire::firmwareSupportsBinary(out.firmware));
+}
+
+void test_snapshot_round_trip() {
+  Wire::SnapshotMessage in = {}, out = {};
+  in.slot = 4;
+  in.color = Rgb(255, 128, 0);
+  in.phase = Phase::ANSWER;
+  in.locked = true;
+  in.hasOpenAt = true;
+  in.openAt = 123456789;
+  in.position = 2;
+  in.active = false;
+  in.epoch = 0xBEEF;
+  in.seq = 44;
+  size_t length = Wire::encode(in, buffer, sizeof(buffer));
+  TEST_ASSERT_TRUE(Wire::isSnapshot(buffer, length));
+  TEST_ASSERT_TRUE(Wire::decode(buffer, length, out));
+  TEST_ASSERT_EQUAL_UINT8(in.slot, out.slot);
+  TEST_ASSERT_EQUAL_UINT8((uint8_t)in.phase, (uint8_t)out.phase);
+  TEST_ASSERT_EQUAL_UINT32(in.openAt, out.openAt);
+  TEST_ASSERT_EQUAL_UINT8(in.position, out.position);
+  TEST_ASSERT_FALSE(out.active);
+  TEST_ASSERT_EQUAL_UINT16(in.seq, out.seq);
+}
+
+void test_queue_delta_round_trip() {
+  Wire::QueueDeltaMessage in = {}, out = {};
+  in.epoch = 0xBEEF;
+  in.seq = 45;
+  in.base = 44;
+  in.op = Wire::QueueOp::PUSH;
+  in.position = 1;
+  in.active = 0;
+  strlcpy(in.id, "C-1a2b3c4d", sizeof(in.id));
+  size_t length = Wire::encode(in, buffer, sizeof(buffer));
+  TEST_ASSERT_TRUE(Wire::isQueueDelta(buffer, length));
+  TEST_ASSERT_TRUE(Wire::decode(buffer, length, out));
+  TEST_ASSERT_EQUAL_UINT16(in.base, out.base);
+  TEST_ASSERT_EQUAL_UINT8((uint8_t)in.op, (uint8_t)out.op);
+  TEST_ASSERT_EQUAL_UINT8(in.position, out.position);
+  TEST_ASSERT_EQUAL_STRING(in.id, out.id);
+}
+
+// Queue - the sequence is appended, a payload without it (older server)
+// decodes with hasSequence unset in either codec
+
+void test_queue_with_and_without_sequence() {
+  for (int c = 0; c < 2; c++) {
+    for (int withSequence = 0; withSequence < 2; withSequence++) {
+      Wire::QueueMessage in = makeQueue(3, withSequence), out = {};
+      in.active = 1;
+      size_t length = Wire::encode(in, (Codec)c, buffer, sizeof(buffer));
+      TEST_ASSERT_TRUE(Wire::decode(buffer, length, out));
+      TEST_ASSERT_EQUAL_UINT8(3, out.length);
+      TEST_ASSERT_EQUAL_INT8(1, out.active);
+      TEST_ASSERT_EQUAL_STRING(in.order[2], out.order[2]);
+      TEST_ASSERT_EQUAL((bool)withSequence, out.hasSequence);
+      TEST_ASSERT_EQUAL_UINT16(in.epoch, out.epoch);
+      TEST_ASSERT_EQUAL_UINT16(in.seq, out.seq);
+    }
+  }
+
+  // Sequence cut off mid-way is malformed, not "no sequence"
+  Wire::QueueMessage in = makeQueue(2, true), out = {};
+  size_t length = Wire::encode(in, Codec::BINARY, buffer, sizeof(buffer));
+  TEST_ASSERT_FALSE(Wire::decode(buffer, length - 1, out));
+
+  // Empty queue, nobody answering
+  in = makeQueue(0, true);
+  length = Wire::encode(in, Codec::BINARY, buffer, sizeof(buffer));
+  TEST_ASSERT_TRUE(Wire::decode(buffer, length, out));
+  TEST_ASSERT_EQUAL_UINT8(0, out.length);
+  TEST_ASSERT_EQUAL_INT8(-1, out.active);
+}
+
+// Buzz offsets - the client patches sequence, flags and press time into a
+// pre-built frame, so the layout must match buzzSeqOffset and friends
+
+void test_buzz_frame_offsets() {
+  Wire::BuzzMessage in = makeBuzz(), out = {};
+  uint8_t idLength = strlen(in.id);
+  size_t length = Wire::encode(in, Codec::BINARY, buffer, sizeof(buffer));
+  TEST_ASSERT_EQUAL_size_t(Wire::buzzTimeOffset(idLength) + 4, length);
+
+  // Patch like the client does, little-endian
+  uint16_t seq = 0x1234;
+  uint32_t pressTime = 0xA1B2C3D4;
+  buffer[Wire::buzzSeqOffset(idLength)] = seq & 0xFF;
+  buffer[Wire::buzzSeqOffset(idLength) + 1] = seq >> 8;
+  buffer[Wire::buzzFlagsOffset(idLength)] |= Wire::Flag::FALSE_START;
+  for (uint8_t i = 0; i < 4; i++) {
+    buffer[Wire::buzzTimeOffset(idLength) + i] = (pressTime >> (8 * i)) & 0xFF;
+  }
+
+  TEST_ASSERT_TRUE(Wire::decode(buffer, length, out));
+  TEST_ASSERT_EQUAL_STRING(in.id, out.id);
+  TEST_ASSERT_EQUAL_UINT16(seq, out.seq);
+  TEST_ASSERT_TRUE(out.falseStart);
+  TEST_ASSERT_EQUAL_UINT32(pressTime, out.timestamp);
+}
+
+// Batch framing
+
+void test_batch_framing() {
+  uint8_t frames[3][WIRE_FRAME_MAX];
+  size_t frameLengths[3];
+  Wire::CommandMessage cmd = makeCommand();
+  Wire::StateMessage state = makeState(true);
+  Wire::QueueMessage queue = makeQueue(4, true);
+  frameLengths[0] = Wire::encode(cmd, Codec::BINARY, frames[0], sizeof(frames[0]));
+  frameLengths[1] = Wire::encode(state, Codec::BINARY, frames[1], sizeof(frames[1]));
+  frameLengths[2] = Wire::encode(queue, Codec::BINARY, frames[2], sizeof(frames[2]));
+
+  size_t length = Wire::beginBatch(buffer, sizeof(buffer));
+  TEST_ASSERT_EQUAL_size_t(2, length);
+  for (uint8_t i = 0; i < 3; i++) {
+    length = Wire::appendToBatch(buffer, length, sizeof(buffer), frames[i], frameLengths[i]);
+    TEST_ASSERT_TRUE(length > 0);
+  }
+  TEST_ASSERT_TRUE(Wire::isBatch(buffer, length));
+
+  size_t offset = 0;
+  const uint8_t* frame;
+  size_t frameLength;
+  for (uint8_t i = 0; i < 3; i++) {
+    TEST_ASSERT_TRUE(Wire::nextBatchFrame(buffer, length, offset, frame, frameLength));
+    TEST_ASSERT_EQUAL_size_t(frameLengths[i], frameLength);
+    TEST_ASSERT_EQUAL_MEMORY(frames[i], frame, frameLength);
+  }
+  TEST_ASSERT_FALSE(Wire::nextBatchFrame(buffer, length, offset, frame, frameLength));
+
+  // Frame that doesn't fit is refused, the batch stays as it was
+  TEST_ASSERT_EQUAL_size_t(0, Wire::appendToBatch(buffer, length, length + frameLengths[0], frames[0], frameLengths[0]));
+
+  // Length byte running past the end stops the walk before that frame
+  offset = 0;
+  uint8_t walked = 0;
+  while (Wire::nextBatchFrame(buffer, length - 1, offset, frame, frameLength)) {
+    walked++;
+  }
+  TEST_ASSERT_EQUAL_UINT8(2, walked);
+}
+
+// Malformed payloads are refused, not half-decoded
+
+void test_truncated_binary_is_rejected() {
+  Wire::CommandMessage cmd = makeCommand(), out = {};
+  size_t length = Wire::encode(cmd, Codec::BINARY, buffer, sizeof(buffer));
+  for (size_t cut = 2; cut < length; cut++) {
+    TEST_ASSERT_FALSE(Wire::decode(buffer, cut, out));
+  }
+
+  // Wrong message type
+  Wire::SyncMessage sync = {};
+  TEST_ASSERT_FALSE(Wire::decode(buffer, length, sync));
+
+  // Too small a buffer encodes nothing
+  TEST_ASSERT_EQUAL_size_t(0, Wire::encode(cmd, Codec::BINARY, buffer, 5));
+  TEST_ASSERT_EQUAL_size_t(0, Wire::encode(cmd, Codec::JSON, buffer, 5));
+}
+
+// Benchmark - bytes on air and host encode/decode time per message, JSON vs
+// binary. Host times only compare the codecs, they are not ESP32 numbers.
+
+constexpr int BENCH_ROUNDS = 20000;
+
+template <class F>
+static double nsPerCall(F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < BENCH_ROUNDS; i++) {
+    f();
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / BENCH_ROUNDS;
+}
+
+static volatile size_t sink;
+
+template <class Msg>
+static void bench(const char* name, const Msg& msg) {
+  uint8_t json[WIRE_FRAME_MAX];
+  uint8_t binary[WIRE_FRAME_MAX];
+  size_t jsonLength = Wire::encode(msg, Codec::JSON, json, sizeof(json));
+  size_t binaryLength = Wire::encode(msg, Codec::BINARY, binary, sizeof(binary));
+  TEST_ASSERT_TRUE(jsonLength > 0 && binaryLength > 0);
+  TEST_ASSERT_LESS_THAN(jsonLength, binaryLength);
+
+  Msg out;
+  double jsonEncode = nsPerCall([&] { sink = Wire::encode(msg, Codec::JSON, json, sizeof(json)); });
+  double binaryEncode = nsPerCall([&] { sink = Wire::encode(msg, Codec::BINARY, binary, sizeof(binary)); });
+  double jsonDecode = nsPerCall([&] { sink = Wire::decode(json, jsonLength, out); });
+  double binaryDecode = nsPerCall([&] { sink = Wire::decode(binary, binaryLength, out); });
+
+  char line[160];
+  snprintf(line, sizeof(line), "%-6s json %3u B %6.0f/%6.0f ns | binary %3u B %5.0f/%5.0f ns | %3.0f%% of json",
+           name, (unsigned)jsonLength, jsonEncode, jsonDecode, (unsigned)binaryLength, binaryEncode, binaryDecode,
+           100.0 * binaryLength / jsonLength);
+  TEST_MESSAGE(line);
+}
+
+void test_benchmark_json_vs_binary() {
+  TEST_MESSAGE("type   size, encode/decode per message");
+  bench("assign", makeAssign());
+  bench("state", makeState(true));
+  bench("queue", makeQueue(MAX_CLIENTS, true));
+  bench("cmd", makeCommand());
+  bench("ack", makeAck());
+  bench("sync", makeSync());
+  bench("buzz", makeBuzz());
+  bench("ping", makePing());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_state_round_trip);
+  RUN_TEST(test_assign_round_trip);
+  RUN_TEST(test_command_round_trip);
+  RUN_TEST(test_ack_round_trip);
+  RUN_TEST(test_sync_round_trip);
+  RUN_TEST(test_buzz_round_trip);
+  RUN_TEST(test_ping_round_trip);
+  RUN_TEST(test_join_round_trip);
+  RUN_TEST(test_snapshot_round_trip);
+  RUN_TEST(test_queue_delta_round_trip);
+  RUN_TEST(test_queue_with_and_without_sequence);
+  RUN_TEST(test_buzz_frame_offsets);
+  RUN_TEST(test_batch_framing);
+  RUN_TEST(test_truncated_binary_is_rejected);
+  RUN_TEST(test_benchmark_json_vs_binary);
+  return UNITY_END();
+}